@@ -132,6 +132,17 @@ bool Player::connect_to_socket(char *socket_path) {
     socklen_t len;
     size_t socket_len;
 
+    // the controller may hand over an already connected socket ("fd:3") instead of a socket path.
+    size_t prefix_len = strlen(SOCKET_FD_PREFIX);
+    if (strncmp(socket_path, SOCKET_FD_PREFIX, prefix_len) == 0) {
+        this->socket_desc = atoi(&socket_path[prefix_len]);
+        if (this->socket_desc < 3) {
+            PRINT_ERROR_F("Invalid socket fd: %s", socket_path);
+            return false;
+        }
+        return true;
+    }
+
     this->socket_desc = socket(AF_UNIX, SOCK_STREAM, 0);
     if (this->socket_desc == -1) {
         PRINT_ERROR(strerror(errno));
@@ -157,12 +168,18 @@ bool Player::connect_to_socket(char *socket_path) {
 }
 
 bool Player::message_send() {
-    if (this->message.size() > MAX_MESSAGE_SIZE) {
-        this->message.resize(MAX_MESSAGE_SIZE);
-    }
-    if (send(this->socket_desc, this->message.c_str(), MAX_MESSAGE_SIZE, 0) == -1) {
-        PRINT_ERROR(strerror(errno));
-        return false;
+    char message_buffer[MAX_MESSAGE_SIZE] = {};
+    size_t length = this->message.size() < MAX_MESSAGE_SIZE ? this->message.size() : MAX_MESSAGE_SIZE;
+    memcpy(message_buffer, this->message.data(), length);
+    size_t sent = 0;
+    while (sent < MAX_MESSAGE_SIZE) {
+        ssize_t rc = send(this->socket_desc, &message_buffer[sent], MAX_MESSAGE_SIZE - sent, 0);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            PRINT_ERROR(strerror(errno));
+            return false;
+        }
+        sent += (size_t)rc;
     }
     return true;
 }
@@ -170,12 +187,21 @@ bool Player::message_send() {
 bool Player::message_receive() {
     this->message.clear();
     char message_buffer[MAX_MESSAGE_SIZE] = {};
-    int size = recv(this->socket_desc, message_buffer, MAX_MESSAGE_SIZE, 0);
-    if (size == -1) {
-        PRINT_ERROR(strerror(errno));
-        return false;
+    // a message can come in split up, so keep reading until all of it is in.
+    size_t received = 0;
+    while (received < MAX_MESSAGE_SIZE) {
+        ssize_t rc = recv(this->socket_desc, &message_buffer[received], MAX_MESSAGE_SIZE - received, 0);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            PRINT_ERROR(strerror(errno));
+            return false;
+        } else if (rc == 0) {
+            PRINT_ERROR("The controller closed the connection!");
+            return false;
+        }
+        received += (size_t)rc;
     }
-    this->message = message_buffer;
+    this->message.assign(message_buffer, strnlen(message_buffer, MAX_MESSAGE_SIZE));
     return true;
 }
 
@@ -31,16 +31,63 @@ bool get_ship_from_shot_result_message(json j, PlayerNum player, Ship &ship) {
     return true;
 }
 
+bool get_shot_result_from_binary_message(const string &message, Shot &shot1, Shot &shot2,
+        Ship &ship1, bool &has_ship1, Ship &ship2, bool &has_ship2, bool &next_shot) {
+    if (message.size() != BINARY_SHOT_RESULT_SIZE) {
+        return false;
+    }
+    const unsigned char *bytes = (const unsigned char *)message.data();
+    int flags = bytes[1];
+    shot1.row = bytes[2];
+    shot1.col = bytes[3];
+    shot1.value = (BoardValue)bytes[4];
+    shot2.row = bytes[5];
+    shot2.col = bytes[6];
+    shot2.value = (BoardValue)bytes[7];
+
+    const unsigned char *ship_bytes[2] = {&bytes[8], &bytes[8 + BINARY_SHIP_SIZE]};
+    Ship *ship[2] = {&ship1, &ship2};
+    for (int i = 0; i < 2; i++) {
+        ship[i]->row = ship_bytes[i][0];
+        ship[i]->col = ship_bytes[i][1];
+        ship[i]->len = ship_bytes[i][2];
+        ship[i]->dir = (Direction)ship_bytes[i][3];
+    }
+    has_ship1 = (flags & BINARY_SHOT_RESULT_SHIP1) != 0;
+    has_ship2 = (flags & BINARY_SHOT_RESULT_SHIP2) != 0;
+    next_shot = (flags & BINARY_SHOT_RESULT_NEXT_SHOT) != 0;
+    return true;
+}
+
 bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *author_names) {
     if (!connect_to_socket(socket_path)) return false;
 
+    // the controller can start us once as a zygote, everything from here on is then done by a copy for each match.
+    if (getenv(ZYGOTE_ENV) != NULL && !run_zygote()) return this->closed;
+
     // hello code
     message_hello_create(ai_name, author_names);
     if (!message_send()) return false;
 
+    // the controller can keep us around for another match, which starts with setup_match again.
+    bool first_match = true, new_match = false;
+    do {
+        if (!play_one_match(first_match, new_match)) return false;
+        first_match = false;
+    } while (new_match);
+    return true;
+}
+
+bool PlayerV2::play_one_match(bool first_match, bool &new_match) {
+    new_match = false;
+
     // setup match code
     {
-        if (!message_receive()) return false;
+        // setup_match always comes the old way, even on a connection that was framed for the last match.
+        this->framed = false;
+        this->binary = false;
+        // NOTE: waiting for another match, the controller closing the connection just means there isn't one.
+        if (!message_receive(!first_match)) return !first_match && this->closed;
 
         json j = json::parse(this->message);
         MessageType type = (MessageType)j[MESSAGE_TYPE_KEY];
@@ -51,6 +98,9 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
 
         PlayerNum player = (PlayerNum)j[PLAYER_NUM_KEY];
         int board_size = (int)j[BOARD_SIZE_KEY];
+        // everything after setup_match is framed, if the controller understood us asking for it.
+        this->framed = j.contains(FRAMING_KEY) && (int)j[FRAMING_KEY] == FRAMING_LENGTH_PREFIXED;
+        this->binary = this->framed && j.contains(ENCODING_KEY) && (int)j[ENCODING_KEY] == ENCODING_BINARY;
 
         handle_setup_match(player, board_size);
     }
@@ -63,8 +113,15 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
             return false;
         }
 
-        json j = json::parse(this->message);
-        type = (MessageType)j[MESSAGE_TYPE_KEY];
+        // binary messages start with their type, JSON ones (place_ships and match_over) always start with '{'.
+        json j;
+        bool is_binary = this->binary && !this->message.empty() && this->message[0] != '{';
+        if (is_binary) {
+            type = (MessageType)(unsigned char)this->message[0];
+        } else {
+            j = json::parse(this->message);
+            type = (MessageType)j[MESSAGE_TYPE_KEY];
+        }
 
         vector<int> ship_lengths = {};
         vector<Ship> ships = {};
@@ -72,8 +129,15 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
         Ship ship1 = {}, ship2 = {};
         bool has_ship1 = false, has_ship2 = false, next_shot = false;
         switch (type) {
-        case MESSAGE_HELLO:
         case MESSAGE_SETUP_MATCH:
+            // between the games of a paired match, to swap seats. Framing and encoding stay as they are.
+            if (is_binary) {
+                PRINT_ERROR_F("Invalid message received: %s", this->message.c_str());
+                return false;
+            }
+            handle_setup_match((PlayerNum)j[PLAYER_NUM_KEY], (int)j[BOARD_SIZE_KEY]);
+            break;
+        case MESSAGE_HELLO:
         case MESSAGE_SHIPS_PLACED:
         case MESSAGE_SHOT_TAKEN:
             PRINT_ERROR_F("Invalid message received: %s", this->message.c_str());
@@ -95,24 +159,31 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
             if (!message_send()) return false;
             break;
         case MESSAGE_SHOT_RESULT:
-            shot1 = get_shot_from_shot_result_message(j, PLAYER_1);
-            shot2 = get_shot_from_shot_result_message(j, PLAYER_2);
+            if (is_binary) {
+                if (!get_shot_result_from_binary_message(this->message, shot1, shot2,
+                        ship1, has_ship1, ship2, has_ship2, next_shot)) {
+                    PRINT_ERROR("Invalid binary \"SHOT_RESULT\" message!");
+                    return false;
+                }
+            } else {
+                shot1 = get_shot_from_shot_result_message(j, PLAYER_1);
+                shot2 = get_shot_from_shot_result_message(j, PLAYER_2);
+                if (j.contains(SHIP_KEY)) {
+                    has_ship1 = get_ship_from_shot_result_message(j, PLAYER_1, ship1);
+                    has_ship2 = get_ship_from_shot_result_message(j, PLAYER_2, ship2);
+                }
+                next_shot = (bool)j[NEXT_SHOT_KEY];
+            }
 
             handle_shot_result(PLAYER_1, shot1);
             handle_shot_result(PLAYER_2, shot2);
-
-            if (j.contains(SHIP_KEY)) {
-                has_ship1 = get_ship_from_shot_result_message(j, PLAYER_1, ship1);
-                has_ship2 = get_ship_from_shot_result_message(j, PLAYER_2, ship2);
-                if (has_ship1) {
-                    handle_ship_dead(PLAYER_1, ship1);
-                }
-                if (has_ship2) {
-                    handle_ship_dead(PLAYER_2, ship2);
-                }
+            if (has_ship1) {
+                handle_ship_dead(PLAYER_1, ship1);
+            }
+            if (has_ship2) {
+                handle_ship_dead(PLAYER_2, ship2);
             }
 
-            next_shot = (bool)j[NEXT_SHOT_KEY];
             if (next_shot) {
                 shot1 = choose_shot();
                 message_shot_taken_create(shot1);
@@ -122,6 +193,7 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
             }
             break;
         case MESSAGE_MATCH_OVER:
+            new_match = j.contains(NEW_MATCH_KEY) && (int)j[NEW_MATCH_KEY] == NEW_MATCH_SUPPORTED;
             handle_match_over();
             break;
         }
@@ -129,11 +201,99 @@ bool PlayerV2::play_match(char *socket_path, const char *ai_name, const char *au
     return true;
 }
 
+bool PlayerV2::run_zygote() {
+    int control_desc = this->socket_desc;
+    // the copies are reaped as soon as they exit, the controller waits for them on its own.
+    signal(SIGCHLD, SIG_IGN);
+
+    int32_t reply = ZYGOTE_READY;
+    if (send(control_desc, &reply, sizeof(reply), 0) != sizeof(reply)) {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+
+    for (;;) {
+        int match_desc = -1;
+        if (!zygote_receive_fork(match_desc)) return false;
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            signal(SIGCHLD, SIG_DFL);
+            // in its own process group, so the controller can kill it without the zygote.
+            setpgid(0, 0);
+            // the zygote has room to fork, the copy gets the limit every other AI starts with before anything else.
+            rlimit process_limit = {};
+            process_limit.rlim_cur = ZYGOTE_PROCESS_LIMIT;
+            process_limit.rlim_max = ZYGOTE_PROCESS_LIMIT;
+            if (setrlimit(RLIMIT_NPROC, &process_limit) == -1) {
+                PRINT_ERROR(strerror(errno));
+                _exit(1);
+            }
+            close(control_desc);
+            this->socket_desc = match_desc;
+            // NOTE: every copy starts with the zygote's random state, so it's reseeded like main() does.
+            srand(getpid());
+            return true;
+        }
+        if (pid == -1) PRINT_ERROR(strerror(errno));
+        close(match_desc);
+
+        reply = (int32_t)pid;
+        if (send(control_desc, &reply, sizeof(reply), 0) != sizeof(reply)) {
+            PRINT_ERROR(strerror(errno));
+            return false;
+        }
+    }
+}
+
+bool PlayerV2::zygote_receive_fork(int &match_desc) {
+    char request = 0;
+    iovec request_vector = {};
+    request_vector.iov_base = &request;
+    request_vector.iov_len = sizeof(request);
+    union {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control = {};
+    msghdr request_header = {};
+    request_header.msg_iov = &request_vector;
+    request_header.msg_iovlen = 1;
+    request_header.msg_control = control.buffer;
+    request_header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t rc;
+    do {
+        rc = recvmsg(this->socket_desc, &request_header, 0);
+    } while (rc == -1 && errno == EINTR);
+    if (rc == 0) {
+        this->closed = true;
+        return false;
+    }
+    cmsghdr *control_header = CMSG_FIRSTHDR(&request_header);
+    if (rc == -1 || request != ZYGOTE_FORK || control_header == NULL || control_header->cmsg_type != SCM_RIGHTS) {
+        PRINT_ERROR(rc == -1 ? strerror(errno) : "Invalid zygote request!");
+        return false;
+    }
+    memcpy(&match_desc, CMSG_DATA(control_header), sizeof(int));
+    return true;
+}
+
 bool PlayerV2::connect_to_socket(char *socket_path) {
     sockaddr_un server_sock;
     socklen_t len;
     size_t socket_len;
 
+    // the controller may hand over an already connected socket ("fd:3") instead of a socket path.
+    size_t prefix_len = strlen(SOCKET_FD_PREFIX);
+    if (strncmp(socket_path, SOCKET_FD_PREFIX, prefix_len) == 0) {
+        this->socket_desc = atoi(&socket_path[prefix_len]);
+        if (this->socket_desc < 3) {
+            PRINT_ERROR_F("Invalid socket fd: %s", socket_path);
+            return false;
+        }
+        return true;
+    }
+
     this->socket_desc = socket(AF_UNIX, SOCK_STREAM, 0);
     if (this->socket_desc == -1) {
         PRINT_ERROR(strerror(errno));
@@ -159,26 +319,79 @@ bool PlayerV2::connect_to_socket(char *socket_path) {
 }
 
 bool PlayerV2::message_send() {
-    if (this->message.size() > MAX_MESSAGE_SIZE) {
-        this->message.resize(MAX_MESSAGE_SIZE);
+    char frame[FRAME_HEADER_SIZE + MAX_MESSAGE_SIZE] = {};
+    size_t length = this->message.size() < MAX_MESSAGE_SIZE - 1 ? this->message.size() : MAX_MESSAGE_SIZE - 1;
+    size_t size = MAX_MESSAGE_SIZE;
+    if (this->framed) {
+        frame[0] = (char)((length >> 8) & 0xff);
+        frame[1] = (char)(length & 0xff);
+        memcpy(&frame[FRAME_HEADER_SIZE], this->message.data(), length);
+        size = FRAME_HEADER_SIZE + length;
+    } else {
+        memcpy(frame, this->message.data(), length);
     }
-    if (send(this->socket_desc, this->message.c_str(), MAX_MESSAGE_SIZE, 0) == -1) {
-        PRINT_ERROR(strerror(errno));
-        return false;
+
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t rc = send(this->socket_desc, &frame[sent], size - sent, 0);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            PRINT_ERROR(strerror(errno));
+            return false;
+        }
+        sent += (size_t)rc;
     }
     return true;
 }
 
-bool PlayerV2::message_receive() {
+bool PlayerV2::message_receive(bool closing_ok) {
     this->message.clear();
-    char message_buffer[MAX_MESSAGE_SIZE] = {};
-    int size = recv(this->socket_desc, message_buffer, MAX_MESSAGE_SIZE, 0);
-    if (size == -1) {
-        PRINT_ERROR(strerror(errno));
-        return false;
+    for (;;) {
+        size_t buffered = this->read_end - this->read_start;
+        size_t size = 0;
+        if (!this->framed) {
+            if (buffered >= MAX_MESSAGE_SIZE) size = MAX_MESSAGE_SIZE;
+        } else if (buffered >= FRAME_HEADER_SIZE) {
+            unsigned char *header = (unsigned char *)&this->read_buffer[this->read_start];
+            size_t length = ((size_t)header[0] << 8) | header[1];
+            if (length > MAX_MESSAGE_SIZE - 1) {
+                PRINT_ERROR("Message frame received is too big!");
+                return false;
+            }
+            if (buffered >= FRAME_HEADER_SIZE + length) size = FRAME_HEADER_SIZE + length;
+        }
+
+        if (size > 0) {
+            const char *start = &this->read_buffer[this->read_start];
+            size_t length = size;
+            if (this->framed) {
+                start += FRAME_HEADER_SIZE;
+                length -= FRAME_HEADER_SIZE;
+            }
+            // binary messages have zero bytes in them, so a framed message is exactly as long as its frame says.
+            this->message.assign(start, this->framed ? length : strnlen(start, length));
+            this->read_start += size;
+            return true;
+        }
+
+        // not all of the message is in yet, make room for the rest of it.
+        if (this->read_start > 0) {
+            memmove(this->read_buffer, &this->read_buffer[this->read_start], buffered);
+            this->read_start = 0;
+            this->read_end = buffered;
+        }
+        ssize_t rc = recv(this->socket_desc, &this->read_buffer[this->read_end], READ_BUFFER_SIZE - this->read_end, 0);
+        if (rc == -1) {
+            if (errno == EINTR) continue;
+            PRINT_ERROR(strerror(errno));
+            return false;
+        } else if (rc == 0) {
+            this->closed = true;
+            if (!closing_ok) PRINT_ERROR("The controller closed the connection!");
+            return false;
+        }
+        this->read_end += (size_t)rc;
     }
-    this->message = message_buffer;
-    return true;
 }
 
 void PlayerV2::message_hello_create(const char *ai_name, const char *author_names) {
@@ -192,11 +405,28 @@ void PlayerV2::message_hello_create(const char *ai_name, const char *author_name
         {MESSAGE_TYPE_KEY, MESSAGE_HELLO},
         {AI_NAME_KEY, ai},
         {AUTHOR_NAMES_KEY, authors},
+        {FRAMING_KEY, FRAMING_LENGTH_PREFIXED},
+        {ENCODING_KEY, ENCODING_BINARY},
+        {NEW_MATCH_KEY, NEW_MATCH_SUPPORTED},
+        {ZYGOTE_KEY, ZYGOTE_SUPPORTED},
     };
     this->message = j.dump();
 }
 
 void PlayerV2::message_ships_placed_create(vector<Ship> ships) {
+    if (this->binary) {
+        this->message.assign(1, (char)MESSAGE_SHIPS_PLACED);
+        this->message.push_back((char)ships.size());
+        for (unsigned int i = 0; i < ships.size(); i++) {
+            Ship ship = ships.at(i);
+            this->message.push_back((char)ship.row);
+            this->message.push_back((char)ship.col);
+            this->message.push_back((char)ship.len);
+            this->message.push_back((char)ship.dir);
+        }
+        return;
+    }
+
     json j = {
         {MESSAGE_TYPE_KEY, MESSAGE_SHIPS_PLACED},
         {SHIP_KEY, json::array()},
@@ -215,6 +445,11 @@ void PlayerV2::message_ships_placed_create(vector<Ship> ships) {
 }
 
 void PlayerV2::message_shot_taken_create(Shot shot) {
+    if (this->binary) {
+        char bytes[BINARY_SHOT_TAKEN_SIZE] = {(char)MESSAGE_SHOT_TAKEN, (char)shot.row, (char)shot.col};
+        this->message.assign(bytes, BINARY_SHOT_TAKEN_SIZE);
+        return;
+    }
     json j = {
         {MESSAGE_TYPE_KEY, MESSAGE_SHOT_TAKEN},
         {ROW_KEY, shot.row},
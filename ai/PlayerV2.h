@@ -8,8 +8,11 @@
 #ifndef PLAYER_V2_H
 #define PLAYER_V2_H
 
+#include <signal.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
@@ -24,9 +27,14 @@ class PlayerV2 {
         PlayerV2() {
             this->socket_desc = 0;
             this->message.clear();
+            this->framed = false;
+            this->binary = false;
+            this->closed = false;
+            this->read_start = 0;
+            this->read_end = 0;
         }
 
-        ~PlayerV2() {
+        virtual ~PlayerV2() {
             // NOTE: if socket_desc is -1 it means an error occurred,
             // if it's 0, 1, or 2 it's stdin, stdout, and stderr.
             if (this->socket_desc >= 3) {
@@ -57,12 +65,31 @@ class PlayerV2 {
         int socket_desc;
 
         string message;
+
+        // NOTE: messages can come in split up, or more than one at a time, so they go through this first.
+        char read_buffer[READ_BUFFER_SIZE];
+        size_t read_start;
+        size_t read_end;
+
+        bool framed;
+        bool binary;
+        bool closed;
     protected:
         bool connect_to_socket(char *socket_path);
 
+        // waits for the controller to ask for copies of us, returns true in each copy (connected to its match), and
+        // false in the zygote once the controller is done with it (closed is set) or something went wrong.
+        bool run_zygote();
+
+        bool zygote_receive_fork(int &match_desc);
+
+        // plays from setup_match to match_over, new_match is set if the controller wants us for another match.
+        bool play_one_match(bool first_match, bool &new_match);
+
         bool message_send();
 
-        bool message_receive(); 
+        // NOTE: with closing_ok, the controller closing the connection isn't printed as an error. closed is set.
+        bool message_receive(bool closing_ok = false);
 
         void message_hello_create(const char *ai_name, const char *author_names);
 
@@ -0,0 +1,115 @@
+/**
+ * @file PlayerV2Plugin.h
+ * @author Matthew Getgen
+ * @brief Turns a PlayerV2 AI into an in-process player (plugin) for the controller.
+ * @date 2026-10-16
+ *
+ * Put BSHIP_PLAYER_V2_PLUGIN(YourPlayer, AI_NAME, AUTHOR_NAMES) in one of your AI's .cpp files, leave out main()
+ * when building it this way, and build it as a shared library ending in .so:
+ *
+ *     g++ -shared -fPIC -DBSHIP_PLAYER_PLUGIN -o your_player.so your_player.cpp
+ *
+ * The controller then calls straight into your player instead of sending it messages. It runs inside of the
+ * controller, so only do this for AIs you trust, and keep all of your state in the player (both players of a
+ * match can be the same library).
+ */
+
+#ifndef PLAYER_V2_PLUGIN_H
+#define PLAYER_V2_PLUGIN_H
+
+#include "../lib/battleshipsplayer.h"
+#include "PlayerV2.h"
+
+template <class T>
+struct PlayerV2Plugin {
+    static void setup_match(void *data, uint8_t player, uint8_t board_size) {
+        ((T *)data)->handle_setup_match((PlayerNum)player, board_size);
+    }
+
+    static void start_game(void *data) {
+        ((T *)data)->handle_start_game();
+    }
+
+    static void choose_ship_placements(void *data, const uint8_t *lengths, uint8_t count, BShip_PlayerShip *ships) {
+        vector<int> ship_lengths(lengths, lengths + count);
+        vector<Ship> chosen = ((T *)data)->choose_ship_placements(ship_lengths);
+        // NOTE: any ship left out stays zeroed, which the controller catches as an invalid length.
+        for (size_t i = 0; i < chosen.size() && i < count; i++) {
+            ships[i] = plugin_ship(chosen[i]);
+        }
+    }
+
+    static BShip_PlayerShot choose_shot(void *data) {
+        Shot shot = ((T *)data)->choose_shot();
+        BShip_PlayerShot plugin_shot = {};
+        plugin_shot.row = (uint8_t)shot.row;
+        plugin_shot.column = (uint8_t)shot.col;
+        return plugin_shot;
+    }
+
+    static void handle_shot_result(void *data, uint8_t player, BShip_PlayerShot plugin_shot) {
+        Shot shot = {};
+        shot.row = plugin_shot.row;
+        shot.col = plugin_shot.column;
+        shot.value = (BoardValue)plugin_shot.value;
+        ((T *)data)->handle_shot_result((PlayerNum)player, shot);
+    }
+
+    static void handle_ship_dead(void *data, uint8_t player, BShip_PlayerShip plugin_ship) {
+        Ship ship = {};
+        ship.row = plugin_ship.row;
+        ship.col = plugin_ship.column;
+        ship.len = plugin_ship.length;
+        ship.dir = (Direction)plugin_ship.direction;
+        ((T *)data)->handle_ship_dead((PlayerNum)player, ship);
+    }
+
+    static void handle_game_over(void *data) {
+        ((T *)data)->handle_game_over();
+    }
+
+    static void handle_match_over(void *data) {
+        ((T *)data)->handle_match_over();
+    }
+
+    static void destroy(void *data) {
+        delete (T *)data;
+    }
+
+    static BShip_PlayerShip plugin_ship(Ship ship) {
+        BShip_PlayerShip plugin_ship = {};
+        plugin_ship.row = (uint8_t)ship.row;
+        plugin_ship.column = (uint8_t)ship.col;
+        plugin_ship.length = (uint8_t)ship.len;
+        plugin_ship.direction = (uint8_t)ship.dir;
+        return plugin_ship;
+    }
+
+    static bool create(BShip_Player *player, uint32_t abi_version, const char *ai_name, const char *author_names) {
+        if (abi_version != BSHIP_PLAYER_ABI_VERSION) {
+            PRINT_ERROR_F("Built for plugin ABI version %d, but the controller uses %d",
+                BSHIP_PLAYER_ABI_VERSION, (int)abi_version);
+            return false;
+        }
+        player->data = new T();
+        player->name = ai_name;
+        player->authors = author_names;
+        player->setup_match = setup_match;
+        player->start_game = start_game;
+        player->choose_ship_placements = choose_ship_placements;
+        player->choose_shot = choose_shot;
+        player->handle_shot_result = handle_shot_result;
+        player->handle_ship_dead = handle_ship_dead;
+        player->handle_game_over = handle_game_over;
+        player->handle_match_over = handle_match_over;
+        player->destroy = destroy;
+        return true;
+    }
+};
+
+#define BSHIP_PLAYER_V2_PLUGIN(player_class, ai_name, author_names) \
+    extern "C" bool BShip_Player_Create(BShip_Player *player, uint32_t abi_version) { \
+        return PlayerV2Plugin<player_class>::create(player, abi_version, ai_name, author_names); \
+    }
+
+#endif // PLAYER_V2_PLUGIN_H
@@ -24,6 +24,11 @@
 
 #define MAX_MESSAGE_SIZE 256
 #define MAX_NAME_SIZE 96
+// Prefix of the first argument when the controller passes a connected socket fd instead of a socket path.
+#define SOCKET_FD_PREFIX "fd:"
+// Framed messages start with a 2 byte big endian length, and aren't padded out to MAX_MESSAGE_SIZE.
+#define FRAME_HEADER_SIZE 2
+#define READ_BUFFER_SIZE (MAX_MESSAGE_SIZE * 4)
 
 // JSON MESSAGE KEYS -- used by the player and server to create and parse messages
 #define MESSAGE_TYPE_KEY "mt"
@@ -38,6 +43,42 @@
 #define SHIP_KEY         "sp"
 #define SHOT_KEY         "st"
 #define NEXT_SHOT_KEY    "ns"
+#define FRAMING_KEY      "fr"
+#define ENCODING_KEY     "en"
+#define NEW_MATCH_KEY    "nm"
+#define ZYGOTE_KEY       "zy"
+
+// Value of FRAMING_KEY to ask for (hello), and to be told we got (setup_match), length prefixed messages.
+#define FRAMING_LENGTH_PREFIXED 1
+// Value of ENCODING_KEY to ask for (hello), and to be told we got (setup_match), binary messages. Only works framed.
+#define ENCODING_BINARY 1
+// Value of NEW_MATCH_KEY to say we can play another match without exiting (hello), and to be told to wait for the
+// setup_match of the next one (match_over).
+#define NEW_MATCH_SUPPORTED 1
+// Value of ZYGOTE_KEY to say we can be started as a zygote (hello).
+#define ZYGOTE_SUPPORTED 1
+
+// ZYGOTE -- set in the environment when the controller starts us as a zygote. The socket we're given is then a
+// control socket: we send ZYGOTE_READY once initialized, then fork a copy of ourselves for each ZYGOTE_FORK byte, and
+// send back its pid. The socket the copy plays its match on comes with the byte. The zygote has room for more
+// processes than an AI gets, so each copy has to set its own RLIMIT_NPROC to ZYGOTE_PROCESS_LIMIT before anything else.
+#define ZYGOTE_ENV "BSHIP_ZYGOTE"
+#define ZYGOTE_READY 0
+#define ZYGOTE_FORK 'f'
+#define ZYGOTE_PROCESS_LIMIT 20
+
+// BINARY MESSAGES -- one byte per field, the first byte is always the MessageType.
+// ships_placed: type, ship count, then row, col, len, dir for each ship.
+#define BINARY_SHIP_SIZE 4
+#define BINARY_SHIPS_PLACED_HEADER_SIZE 2
+// shot_taken: type, row, col.
+#define BINARY_SHOT_TAKEN_SIZE 3
+// shot_result: type, flags, row, col, value for each shot, then row, col, len, dir for each ship.
+#define BINARY_SHOT_SIZE 3
+#define BINARY_SHOT_RESULT_SIZE (2 + (BINARY_SHOT_SIZE * 2) + (BINARY_SHIP_SIZE * 2))
+#define BINARY_SHOT_RESULT_NEXT_SHOT 0x1
+#define BINARY_SHOT_RESULT_SHIP1     0x2
+#define BINARY_SHOT_RESULT_SHIP2     0x4
 
 /// @brief Message Types that are sent and received. Ordered by occurrence in protocol.
 enum MessageType {
@@ -11,6 +11,12 @@
 
 #define AUTHOR_NAMES "Example Team/Author Name"
 
+#ifdef BSHIP_PLAYER_PLUGIN
+// built as a plugin (see PlayerV2Plugin.h), the controller creates the player itself.
+#include "../PlayerV2Plugin.h"
+
+BSHIP_PLAYER_V2_PLUGIN(ExamplePlayerV2, AI_NAME, AUTHOR_NAMES)
+#else
 int main(int argc, char *argv[]) {
     if (argc != 2) {
         PRINT_ERROR("AI Requires a socket path!");
@@ -27,6 +33,7 @@ int main(int argc, char *argv[]) {
     }
     return 0;
 }
+#endif
 
 ExamplePlayerV2::ExamplePlayerV2():PlayerV2() {
     this->ship_lengths = {};
@@ -0,0 +1,520 @@
+/**
+ * @file bench.c
+ * @author Matthew Getgen
+ * @brief Microbenchmarks for the library's hot paths, printed as CSV or JSON so runs can be compared.
+ * @date 2026-10-16
+ *
+ * Build it with `./build.sh bench [unix|linux_uring]`, then run `./battleships_bench [csv|json]`.
+ */
+
+// NOTE(mattg): this includes the library instead of linking it, so the functions that aren't in the header can be
+// timed too. The platform and yyjson objects are still linked in the usual way.
+#include "lib/runtime.c"
+
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define BENCH_BOARD_SIZE 10
+#define BENCH_SOCKET_PATH "/tmp/battleships_bench.sock"
+
+typedef struct {
+    uint64_t cycles;
+    struct timespec time;
+} Timer;
+
+typedef struct {
+    const char *name;
+    uint64_t operations;
+    uint64_t cycles;
+    uint64_t nanoseconds;
+} BenchResult;
+
+typedef enum {
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON,
+} BenchFormat;
+
+static inline void Timer_Get(Timer *timer)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    timer->cycles = __rdtsc();
+#else
+    timer->cycles = 0;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &timer->time);
+}
+
+static BenchResult BenchResult_From_Timers(const char *name, uint64_t operations, Timer start, Timer end)
+{
+    BenchResult result = {
+        .name = name,
+        .operations = operations,
+        .cycles = end.cycles - start.cycles,
+        .nanoseconds = ((uint64_t)(end.time.tv_sec - start.time.tv_sec) * 1000000000ull)
+            + (uint64_t)(end.time.tv_nsec - start.time.tv_nsec),
+    };
+    return result;
+}
+
+static void BenchResult_Print(BenchResult result, BenchFormat format, bool first)
+{
+    double cycles = (double)result.cycles / (double)result.operations;
+    double nanoseconds = (double)result.nanoseconds / (double)result.operations;
+    double per_second = nanoseconds > 0.0 ? 1e9 / nanoseconds : 0.0;
+    switch (format)
+    {
+    case BENCH_FORMAT_CSV:
+        printf("%s,%lu,%.1f,%.1f,%.0f\n", result.name, (unsigned long)result.operations, cycles, nanoseconds,
+            per_second);
+        break;
+    case BENCH_FORMAT_JSON:
+        printf("%s\n    {\"name\": \"%s\", \"operations\": %lu, \"cycles_per_op\": %.1f, \"ns_per_op\": %.1f, "
+            "\"ops_per_sec\": %.0f}", first ? "" : ",", result.name, (unsigned long)result.operations, cycles,
+            nanoseconds, per_second);
+        break;
+    }
+}
+
+// NOTE(mattg): keeps the compiler from moving work out of the loop, since most bodies do the same thing every time.
+#if defined(__GNUC__)
+#define BENCH_CLOBBER() __asm__ __volatile__("" ::: "memory")
+#else
+#define BENCH_CLOBBER()
+#endif
+
+// Runs the body (everything after count) count times between two timers. Anything it needs has to be set up first.
+#define BENCH(results, result_count, bench_name, count, ...) \
+    do { \
+        Timer __start, __end; \
+        Timer_Get(&__start); \
+        for (uint64_t __i = 0; __i < (count); __i++) \
+        { \
+            __VA_ARGS__; \
+            BENCH_CLOBBER(); \
+        } \
+        Timer_Get(&__end); \
+        results[(result_count)++] = BenchResult_From_Timers(bench_name, (count), __start, __end); \
+    } while (0)
+
+// NOTE(mattg): keeps the compiler from throwing away work whose result isn't used.
+static volatile uint64_t bench_sink;
+
+static void Bench_Messages(BShip_Arena *arena, BenchResult *results, uint32_t *result_count)
+{
+    const uint64_t count = 1000000;
+    char buffer[BSHIP_MESSAGE_SIZE] = {0};
+    BShip_Message message = { .buffer = buffer };
+
+    uint8_t ship_lengths[BSHIP_SHIP_COUNT_MAX] = {5, 4, 3, 3, 2};
+    BShip_Shot shot1 = { .row = 3, .column = 4, .value = BSHIP_HIT };
+    BShip_Shot shot2 = { .row = 9, .column = 0, .value = BSHIP_MISS };
+    BShip_Ship ship = { .row = 2, .column = 3, .length = 4, .direction = BSHIP_VERTICAL };
+    BShip_Ship ships_buffer[BSHIP_SHIP_COUNT_MAX];
+    BShip_ShipArray ships = { .buffer = ships_buffer, .capacity = BSHIP_SHIP_COUNT_MAX };
+    BShip_Shot shot = {0};
+
+    BENCH(results, *result_count, "message_setup_match_create", count,
+        BShip_Message_SetupMatch_Create(&message, BENCH_BOARD_SIZE, BSHIP_PLAYER_1, true, MESSAGE_ENCODING_BINARY));
+    BENCH(results, *result_count, "message_place_ships_create", count,
+        BShip_Message_PlaceShips_Create(&message, ship_lengths, 5));
+    BENCH(results, *result_count, "message_shot_result_create_json", count,
+        BShip_Message_ShotResult_Create(&message, shot1, shot2, (__i & 7) ? NULL : &ship, NULL, true,
+            MESSAGE_ENCODING_JSON));
+    BENCH(results, *result_count, "message_shot_result_create_binary", count,
+        BShip_Message_ShotResult_Create(&message, shot1, shot2, (__i & 7) ? NULL : &ship, NULL, true,
+            MESSAGE_ENCODING_BINARY));
+    BENCH(results, *result_count, "message_match_over_create", count,
+        BShip_Message_MatchOver_Create(&message, true));
+
+    char ai_name[BSHIP_MESSAGE_NAME_SIZE_MAX], author_names[BSHIP_MESSAGE_NAME_SIZE_MAX];
+    bool framed = false, new_match = false, zygote = false;
+    BShip_MessageEncoding encoding = MESSAGE_ENCODING_JSON;
+    message.length = (uint8_t)snprintf(buffer, sizeof(buffer),
+        "{\"mt\":0,\"ai\":\"Bench Player\",\"au\":\"Matthew Getgen\",\"fr\":1,\"en\":1,\"nm\":1,\"zy\":1}");
+    BENCH(results, *result_count, "message_hello_parse", count,
+        bench_sink += BShip_Message_Hello_Parse(arena, message, ai_name, author_names, &framed, &encoding,
+            &new_match, &zygote));
+
+    message.length = (uint8_t)snprintf(buffer, sizeof(buffer),
+        "{\"mt\":3,\"sp\":[[0,0,5,0],[1,0,4,0],[2,0,3,0],[3,0,3,0],[4,0,2,0]]}");
+    BENCH(results, *result_count, "message_ships_placed_parse_json", count,
+        bench_sink += BShip_Message_ShipsPlaced_Parse(arena, message, &ships, 5, MESSAGE_ENCODING_JSON));
+    uint8_t *bytes = (uint8_t *)buffer;
+    bytes[0] = MESSAGE_SHIPS_PLACED;
+    bytes[1] = 5;
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        uint8_t *ship_bytes = &bytes[BINARY_SHIPS_PLACED_HEADER_SIZE + (i * BINARY_SHIP_SIZE)];
+        ship_bytes[0] = i;
+        ship_bytes[1] = 0;
+        ship_bytes[2] = ship_lengths[i];
+        ship_bytes[3] = BSHIP_HORIZONTAL;
+    }
+    message.length = BINARY_SHIPS_PLACED_HEADER_SIZE + (5 * BINARY_SHIP_SIZE);
+    BENCH(results, *result_count, "message_ships_placed_parse_binary", count,
+        bench_sink += BShip_Message_ShipsPlaced_Parse(arena, message, &ships, 5, MESSAGE_ENCODING_BINARY));
+
+    message.length = (uint8_t)snprintf(buffer, sizeof(buffer), "{\"mt\":4,\"r\":7,\"c\":3}");
+    BENCH(results, *result_count, "message_shot_taken_parse_json", count,
+        bench_sink += BShip_Message_ShotTaken_Parse(arena, message, &shot, MESSAGE_ENCODING_JSON));
+    bytes[0] = MESSAGE_SHOT_TAKEN;
+    bytes[1] = 7;
+    bytes[2] = 3;
+    message.length = BINARY_SHOT_TAKEN_SIZE;
+    BENCH(results, *result_count, "message_shot_taken_parse_binary", count,
+        bench_sink += BShip_Message_ShotTaken_Parse(arena, message, &shot, MESSAGE_ENCODING_BINARY));
+}
+
+static void Bench_Game(BShip_Arena *arena, BenchResult *results, uint32_t *result_count)
+{
+    const uint64_t count = 1000000;
+    BSHIP_ARENA_TEMP_BEGIN(arena);
+    uint8_t ship_count_max = ShipCountMax_From_BoardSize(BENCH_BOARD_SIZE);
+    BShip_Board board = BShip_Board_Allocate(arena, BENCH_BOARD_SIZE);
+    BShip_Board placed_board = BShip_Board_Allocate(arena, BENCH_BOARD_SIZE);
+    BShip_U8Array ship_lengths = {
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    BShip_U8Array ship_lengths_copy = {
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    BShip_ShipArray ships = {
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_Ship, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    BShip_U8Array alive_ships = {
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    BShip_U8Array dead_ships = {
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    ShipLengths_Calculate(&ship_lengths, BoardRules_Get(BENCH_BOARD_SIZE));
+    // one horizontal ship per row, starting at the left edge.
+    for (ships.length = 0; ships.length < ship_lengths.length; ships.length++)
+    {
+        BShip_Ship ship = {
+            .row = ships.length,
+            .length = ship_lengths.buffer[ships.length],
+            .direction = BSHIP_HORIZONTAL,
+        };
+        ships.buffer[ships.length] = ship;
+    }
+    size_t board_area = BENCH_BOARD_SIZE * BENCH_BOARD_SIZE;
+    size_t planes_size = sizeof(BShip_BoardPlanes);
+
+    // NOTE(mattg): each one starts from an empty board, the reset is part of the time.
+    BENCH(results, *result_count, "validate_and_store_ships", count,
+        memset(board.planes, 0, planes_size);
+        memcpy(ship_lengths_copy.buffer, ship_lengths.buffer, ship_lengths.length);
+        ship_lengths_copy.length = ship_lengths.length;
+        alive_ships.length = 0;
+        bench_sink += ValidateAndStoreShips(board, &ships, &alive_ships, &ship_lengths_copy).type);
+    memcpy(placed_board.planes, board.planes, planes_size);
+
+    // NOTE(mattg): goes over every square, then puts the ships back, so it's a mix of hits and misses.
+    BENCH(results, *result_count, "validate_and_store_shot", count,
+        uint8_t square = (uint8_t)(__i % board_area);
+        if (square == 0)
+        {
+            memcpy(board.planes, placed_board.planes, planes_size);
+        }
+        BShip_Shot shot = { .row = square / BENCH_BOARD_SIZE, .column = square % BENCH_BOARD_SIZE };
+        bench_sink += ValidateAndStoreShot(board, &shot).type);
+
+    // every ship hit but its last square, then a hit on the first ship that doesn't kill it.
+    memcpy(board.planes, placed_board.planes, planes_size);
+    for (uint8_t i = 0; i < ships.length; i++)
+    {
+        for (uint8_t j = 0; j + 1 < ships.buffer[i].length; j++)
+        {
+            BShip_Shot shot = { .row = ships.buffer[i].row, .column = j };
+            ValidateAndStoreShot(board, &shot);
+        }
+    }
+    BShip_Shot hit = { .row = 0, .column = 0, .value = BSHIP_HIT };
+    BENCH(results, *result_count, "find_dead_ship", count,
+        bench_sink += (uint64_t)(uintptr_t)FindDeadShip(board, ships, hit, &alive_ships, &dead_ships));
+    BSHIP_ARENA_TEMP_END(arena);
+}
+
+static void Bench_Arena(BShip_Arena *arena, BenchResult *results, uint32_t *result_count)
+{
+    const uint64_t count = 10000000;
+    BENCH(results, *result_count, "arena_push_rollback", count,
+        BSHIP_ARENA_TEMP_BEGIN(arena);
+        bench_sink += (uint64_t)(uintptr_t)BShip_Arena_Push(arena, 64);
+        BSHIP_ARENA_TEMP_END(arena));
+}
+
+// A built-in player for the simulation bench: ships one per row, shots at every square in a random order.
+typedef struct {
+    uint64_t random;
+    uint8_t board_size;
+    uint8_t shot_next;
+    uint8_t shot_order[BSHIP_SHOT_LENGTH_MAX];
+} BenchPlayer;
+
+static void BenchPlayer_SetupMatch(void *data, uint8_t player, uint8_t board_size)
+{
+    BenchPlayer *bench_player = data;
+    bench_player->random = 0x9E3779B97F4A7C15ull * player;
+    bench_player->board_size = board_size;
+}
+
+static void BenchPlayer_StartGame(void *data)
+{
+    BenchPlayer *bench_player = data;
+    // NOTE(mattg): squares are kept as row << 4 | column, so a shot doesn't cost two divides.
+    uint8_t area = bench_player->board_size * bench_player->board_size;
+    for (uint8_t i = 0; i < area; i++)
+    {
+        bench_player->shot_order[i] = (uint8_t)(((i / bench_player->board_size) << 4) | (i % bench_player->board_size));
+    }
+    for (uint8_t i = area - 1; i > 0; i--)
+    {
+        // xorshift64
+        bench_player->random ^= bench_player->random << 13;
+        bench_player->random ^= bench_player->random >> 7;
+        bench_player->random ^= bench_player->random << 17;
+        uint8_t j = (uint8_t)(((bench_player->random >> 32) * (uint64_t)(i + 1)) >> 32);
+        uint8_t square = bench_player->shot_order[i];
+        bench_player->shot_order[i] = bench_player->shot_order[j];
+        bench_player->shot_order[j] = square;
+    }
+    bench_player->shot_next = 0;
+}
+
+static void BenchPlayer_ChooseShipPlacements(void *data, const uint8_t *lengths, uint8_t count,
+    BShip_PlayerShip *ships)
+{
+    (void)data;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        ships[i] = (BShip_PlayerShip){ .row = i, .length = lengths[i], .direction = BSHIP_HORIZONTAL };
+    }
+}
+
+static BShip_PlayerShot BenchPlayer_ChooseShot(void *data)
+{
+    BenchPlayer *bench_player = data;
+    uint8_t square = bench_player->shot_order[bench_player->shot_next++];
+    return (BShip_PlayerShot){
+        .row = square >> 4,
+        .column = square & 0xF,
+    };
+}
+
+static void BenchPlayer_HandleShotResult(void *data, uint8_t player, BShip_PlayerShot shot)
+{
+    (void)data;
+    (void)player;
+    (void)shot;
+}
+
+static void BenchPlayer_HandleShipDead(void *data, uint8_t player, BShip_PlayerShip ship)
+{
+    (void)data;
+    (void)player;
+    (void)ship;
+}
+
+static void BenchPlayer_Nothing(void *data)
+{
+    (void)data;
+}
+
+static BShip_Player BenchPlayer_Create(BenchPlayer *bench_player)
+{
+    return (BShip_Player){
+        .data = bench_player,
+        .name = "Bench Player",
+        .authors = "Bench",
+        .setup_match = BenchPlayer_SetupMatch,
+        .start_game = BenchPlayer_StartGame,
+        .choose_ship_placements = BenchPlayer_ChooseShipPlacements,
+        .choose_shot = BenchPlayer_ChooseShot,
+        .handle_shot_result = BenchPlayer_HandleShotResult,
+        .handle_ship_dead = BenchPlayer_HandleShipDead,
+        .handle_game_over = BenchPlayer_Nothing,
+        .handle_match_over = BenchPlayer_Nothing,
+        .destroy = BenchPlayer_Nothing,
+    };
+}
+
+static void Bench_Simulate(BShip_Arena *arena, BenchResult *results, uint32_t *result_count)
+{
+    const uint64_t count = 100000;
+    BenchPlayer bench_player1 = {0}, bench_player2 = {0};
+    BShip_Player player1 = BenchPlayer_Create(&bench_player1);
+    BShip_Player player2 = BenchPlayer_Create(&bench_player2);
+    player1.setup_match(player1.data, BSHIP_PLAYER_1, BENCH_BOARD_SIZE);
+    player2.setup_match(player2.data, BSHIP_PLAYER_2, BENCH_BOARD_SIZE);
+    const BShip_BoardRules *rules = BoardRules_Get(BENCH_BOARD_SIZE);
+    BShip_GameState game_state;
+    BENCH(results, *result_count, "game_allocate", count,
+        BSHIP_ARENA_TEMP_BEGIN(arena);
+        bench_sink += Game_Allocate(&game_state, arena, rules);
+        BSHIP_ARENA_TEMP_END(arena));
+    BENCH(results, *result_count, "simulate_game", count,
+        BSHIP_ARENA_TEMP_BEGIN(arena);
+        BShip_GameData game = BShip_Game_Simulate(arena, &player1, &player2, BENCH_BOARD_SIZE);
+        bench_sink += game.ai1.shots.length;
+        BSHIP_ARENA_TEMP_END(arena));
+}
+
+// Stands in for an AI, by sending back everything it gets.
+static void Bench_EchoPeer(void)
+{
+    int socket_desc = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un socket_address = { .sun_family = AF_UNIX };
+    strncpy(socket_address.sun_path, BENCH_SOCKET_PATH, sizeof(socket_address.sun_path) - 1);
+    if (socket_desc == -1 || connect(socket_desc, (struct sockaddr *)&socket_address, sizeof(socket_address)) == -1)
+    {
+        _exit(1);
+    }
+    char buffer[4096];
+    for (;;)
+    {
+        ssize_t received = recv(socket_desc, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        for (ssize_t sent = 0; sent < received;)
+        {
+            ssize_t rc = send(socket_desc, &buffer[sent], received - sent, MSG_NOSIGNAL);
+            if (rc <= 0)
+            {
+                _exit(1);
+            }
+            sent += rc;
+        }
+    }
+    _exit(0);
+}
+
+static void Bench_Socket(BShip_Arena *arena, BenchResult *results, uint32_t *result_count)
+{
+    const uint64_t count = 100000;
+    BSHIP_ARENA_TEMP_BEGIN(arena);
+    BShip_Connection *conn = BShip_Arena_Push(arena, BShip_Connection_GetSize());
+    BShip_AIConnection *ai_conn = BShip_Arena_Push(arena, BShip_AIConnection_GetSize());
+    BShip_Reactor *reactor = BShip_Arena_Push(arena, BShip_Reactor_GetSize(1));
+    char buffer[BSHIP_MESSAGE_SIZE] = {0};
+    BShip_Message message = { .buffer = buffer };
+    if (conn == NULL || ai_conn == NULL || reactor == NULL || !BShip_Connection_Create(conn, BENCH_SOCKET_PATH))
+    {
+        BSHIP_ARENA_TEMP_END(arena);
+        return;
+    }
+    memset(ai_conn, 0, BShip_AIConnection_GetSize());
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        Bench_EchoPeer();
+    }
+    if (pid == -1 || BShip_AIConnection_Accept(ai_conn, conn, false) != ERROR_SUCCESS)
+    {
+        BShip_Connection_Close(conn);
+        BSHIP_ARENA_TEMP_END(arena);
+        return;
+    }
+    if (!BShip_Reactor_Create(reactor, 1) || !BShip_Reactor_Add(reactor, ai_conn, NULL))
+    {
+        BShip_AIConnection_Close(ai_conn);
+        BShip_Connection_Close(conn);
+        BSHIP_ARENA_TEMP_END(arena);
+        return;
+    }
+
+    // a shot result goes out and comes straight back, the way a round of a match goes through the reactor.
+    BShip_Shot shot1 = { .row = 3, .column = 4, .value = BSHIP_HIT };
+    BShip_Shot shot2 = { .row = 9, .column = 0, .value = BSHIP_MISS };
+    const char *names[2] = {"socket_round_trip_unframed", "socket_round_trip_framed_binary"};
+    for (uint32_t framed = 0; framed < 2; framed++)
+    {
+        BShip_AIConnection_SetFramed(ai_conn, framed);
+        BShip_MessageEncoding encoding = framed ? MESSAGE_ENCODING_BINARY : MESSAGE_ENCODING_JSON;
+        bool failed = false;
+        BENCH(results, *result_count, names[framed], count,
+            BShip_Message_ShotResult_Create(&message, shot1, shot2, NULL, NULL, true, encoding);
+            BShip_ReactorEvent event;
+            if (BShip_AIConnection_Send(ai_conn, message, false) != ERROR_SUCCESS
+                || (BShip_Reactor_Expect(reactor, ai_conn, false), BShip_Reactor_Wait(reactor, &event, 1)) != 1
+                || event.type != BSHIP_REACTOR_READABLE
+                || BShip_AIConnection_Read(ai_conn, &message) != ERROR_SUCCESS)
+            {
+                failed = true;
+                break;
+            });
+        if (failed)
+        {
+            fprintf(stderr, "%s failed, leaving it out\n", names[framed]);
+            (*result_count)--;
+            break;
+        }
+    }
+
+    BShip_Reactor_Remove(reactor, ai_conn);
+    BShip_Reactor_Close(reactor);
+    BShip_AIConnection_Close(ai_conn);
+    BShip_Connection_Close(conn);
+    waitpid(pid, NULL, 0);
+    BSHIP_ARENA_TEMP_END(arena);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFormat format = BENCH_FORMAT_CSV;
+    if (argc > 1 && strcmp(argv[1], "json") == 0)
+    {
+        format = BENCH_FORMAT_JSON;
+    }
+    else if (argc > 1 && strcmp(argv[1], "csv") != 0)
+    {
+        fprintf(stderr, "Usage: %s [csv|json]\n", argv[0]);
+        return 1;
+    }
+
+    BShip_Arena arena = {0};
+    BShip_Arena_Initialize(&arena, BShip_Match_CalculateMemorySize(BENCH_BOARD_SIZE, 1));
+
+    BenchResult results[32];
+    uint32_t result_count = 0;
+    Bench_Messages(&arena, results, &result_count);
+    Bench_Game(&arena, results, &result_count);
+    Bench_Arena(&arena, results, &result_count);
+    Bench_Simulate(&arena, results, &result_count);
+    Bench_Socket(&arena, results, &result_count);
+    BShip_Arena_Destroy(&arena);
+
+    switch (format)
+    {
+    case BENCH_FORMAT_CSV:
+        printf("name,operations,cycles_per_op,ns_per_op,ops_per_sec\n");
+        break;
+    case BENCH_FORMAT_JSON:
+        printf("[");
+        break;
+    }
+    for (uint32_t i = 0; i < result_count; i++)
+    {
+        BenchResult_Print(results[i], format, i == 0);
+    }
+    if (format == BENCH_FORMAT_JSON)
+    {
+        printf("\n]\n");
+    }
+    return 0;
+}
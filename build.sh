@@ -3,6 +3,7 @@
 set -e
 
 MODE="${1:-debug}"
+PLATFORM="${2:-unix}"
 
 
 COMMON_FLAGS=(
@@ -19,11 +20,21 @@ DEBUG_FLAGS=(
     -fsanitize=undefined
 )
 
+# NOTE(mattg): asserts are for debug builds, the hot paths check every board access with them.
 RELEASE_FLAGS=(
     -Werror
     -O3
     -march=native
     -flto
+    -DNDEBUG
+)
+
+# NOTE(mattg): optimized like release, but with gcc and symbols, so perf and the bench build work anywhere.
+BENCH_FLAGS=(
+    -O3
+    -march=native
+    -g
+    -DNDEBUG
 )
 
 case "$MODE" in
@@ -35,14 +46,25 @@ case "$MODE" in
         CC=clang
         CFLAGS=("${COMMON_FLAGS[@]}" "${RELEASE_FLAGS[@]}")
         ;;
+    bench)
+        CC=gcc
+        CFLAGS=("${COMMON_FLAGS[@]}" "${BENCH_FLAGS[@]}")
+        ;;
     *)
-        echo "Usage: $0 [debug|release]"
+        echo "Usage: $0 [debug|release|bench] [unix|linux_uring]"
         exit 1
         ;;
 esac
 
-cd lib && ./build.sh "$MODE" && cd ..
+cd lib && ./build.sh "$MODE" "$PLATFORM" && cd ..
+
+if [ "$MODE" = "bench" ]; then
+    # NOTE(mattg): bench.c includes runtime.c itself, so only the platform and yyjson objects are linked.
+    echo "building battleships_bench..."
+    $CC "${CFLAGS[@]}" bench.c "lib/build/platforms/$PLATFORM.o" lib/build/yyjson_bench.o -o battleships_bench -lm -lpthread -ldl
+    exit 0
+fi
 
 echo "building battleships..."
-$CC "${CFLAGS[@]}" main.c lib/battleshipslib.a -o battleships -lm
+$CC "${CFLAGS[@]}" main.c lib/battleshipslib.a -o battleships -lm -lpthread -ldl
 
@@ -13,11 +13,19 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "battleshipsplayer.h"
+
 #define BSHIP_ARENA_BLOCK_SIZE_DEFAULT 4096
 #define BSHIP_BOARD_SIZE_MIN 5
 #define BSHIP_BOARD_SIZE_MAX 15
+#define BSHIP_CONTEST_AI_COUNT_MIN 2
+#define BSHIP_CONTEST_LIVES_MAX 3
+#define BSHIP_CONTEST_THREAD_COUNT_MAX 256
+#define BSHIP_CONTEST_MATCHES_PER_THREAD_MAX 64
 #define BSHIP_GAMES_PER_MATCH_MAX 10000
 #define BSHIP_GAMES_PER_MATCH_MIN 1
+// NOTE(mattg): AIs whose share of the decided games is within this much of half can be stopped early as even.
+#define BSHIP_MATCH_STOP_MARGIN 0.05
 #define BSHIP_MESSAGE_SIZE 256
 #define BSHIP_MESSAGE_NAME_SIZE_MAX 96
 #define BSHIP_SHIP_COUNT_MIN 3
@@ -111,8 +119,58 @@ typedef struct {
     uint32_t capacity;
 } BShip_ShotArray;
 
+// NOTE(mattg): the games kept with a match store their ships and shots packed into 2 bytes each, one column of them
+// per AI, instead of the padded structs above. A match of 10000 games on a 15x15 board is mostly shots.
+// Read them with the BSHIP_PACKED_* macros (or unpack them), the bits aren't part of the API.
+// A shot is the column in bits 0-3, the row in bits 4-7, and the value in bits 8-10.
+typedef uint16_t BShip_PackedShot;
+// A ship is the column in bits 0-3, the row in bits 4-7, the length in bits 8-11, and the direction in bits 12-15.
+typedef uint16_t BShip_PackedShip;
+
+#define BSHIP_PACKED_SHOT_ROW(shot) ((uint8_t)(((shot) >> 4) & 0xF))
+#define BSHIP_PACKED_SHOT_COLUMN(shot) ((uint8_t)((shot) & 0xF))
+#define BSHIP_PACKED_SHOT_VALUE(shot) ((BShip_BoardValue)(((shot) >> 8) & 0x7))
+#define BSHIP_PACKED_SHIP_ROW(ship) ((uint8_t)(((ship) >> 4) & 0xF))
+#define BSHIP_PACKED_SHIP_COLUMN(ship) ((uint8_t)((ship) & 0xF))
+#define BSHIP_PACKED_SHIP_LENGTH(ship) ((uint8_t)(((ship) >> 8) & 0xF))
+#define BSHIP_PACKED_SHIP_DIRECTION(ship) ((BShip_Direction)(((ship) >> 12) & 0xF))
+
 typedef struct {
-    uint8_t *buffer;
+    BShip_PackedShip *buffer;
+    uint32_t length;
+    uint32_t capacity;
+} BShip_PackedShipArray;
+
+typedef struct {
+    BShip_PackedShot *buffer;
+    uint32_t length;
+    uint32_t capacity;
+} BShip_PackedShotArray;
+
+// NOTE(mattg): one bit per square. Every row gets 16 bits, even though it's at most 15 squares, so a row never
+// crosses a word and a horizontal ship is a single shift.
+#define BSHIP_BOARD_ROW_BITS 16
+#define BSHIP_BOARD_WORD_COUNT ((BSHIP_BOARD_SIZE_MAX * BSHIP_BOARD_ROW_BITS + 63) / 64)
+
+typedef struct {
+    uint64_t words[BSHIP_BOARD_WORD_COUNT];
+} BShip_BoardMask;
+
+typedef struct {
+    BShip_BoardMask ships;
+    BShip_BoardMask hits;
+    BShip_BoardMask misses;
+    BShip_BoardMask kills;
+    // the squares of each ship, by its index in the ship array, filled in when the ships are validated.
+    BShip_BoardMask ship_masks[BSHIP_SHIP_COUNT_MAX];
+    // the index of the ship on each square (only valid where the ships plane is set), and how many
+    // squares of each ship haven't been hit yet. A hit counts down its ship, which is dead at zero.
+    uint8_t ship_at[BSHIP_BOARD_SIZE_MAX * BSHIP_BOARD_ROW_BITS];
+    uint8_t hits_left[BSHIP_SHIP_COUNT_MAX];
+} BShip_BoardPlanes;
+
+typedef struct {
+    BShip_BoardPlanes *planes;
     uint8_t size;
 } BShip_Board;
 
@@ -161,10 +219,10 @@ typedef struct {
 
 typedef struct {
     BShip_Error error;
-    BShip_ShipArray ships;
+    BShip_PackedShipArray ships;
     BShip_U8Array alive_ships;
     BShip_U8Array dead_ships;
-    BShip_ShotArray shots;
+    BShip_PackedShotArray shots;
     uint32_t num_board_shot;
     uint32_t hits;
     uint32_t misses;
@@ -186,6 +244,18 @@ typedef struct {
     uint32_t capacity;
 } BShip_GameDataArray;
 
+// NOTE(mattg): what an AI's process used in a match, collected when it exits, or read from /proc at match over for an
+// AI that keeps running in the pool (or was forked by a zygote). An AI reused from the pool only counts what it used
+// since its last match.
+typedef struct {
+    double user_seconds;
+    double system_seconds;
+    uint64_t max_resident_kilobytes;
+    uint64_t voluntary_context_switches;
+    uint64_t involuntary_context_switches;
+    bool measured;
+} BShip_AIUsage;
+
 typedef struct {
     BShip_Error error;
     char *name;
@@ -200,22 +270,110 @@ typedef struct {
     uint32_t total_misses;
     uint32_t total_duplicates;
     uint32_t total_ships_killed;
+    // NOTE(mattg): only for paired matches, from the games this AI won minus the ones it lost in each pair.
+    uint32_t pair_wins;
+    uint32_t pair_losses;
+    uint32_t pair_ties;
+    // NOTE(mattg): only the games this AI won by sinking every ship count here, indexed by the shots it took.
+    // The mean and variance are kept up to date as the games end, over shots_to_win_count games.
+    uint32_t shots_to_win[BSHIP_SHOT_LENGTH_MAX + 1];
+    uint32_t shots_to_win_count;
+    double shots_to_win_mean;
+    double shots_to_win_variance;
+    bool reused; // NOTE(mattg): the AI was already running in the pool, from an earlier match.
+    BShip_AIUsage usage;
 } BShip_AIMatchData;
 
 typedef struct {
     BShip_AIMatchData ai1;
     BShip_AIMatchData ai2;
-    BShip_GameDataArray games;
+    BShip_GameDataArray games; // NOTE(mattg): stays empty when the games go to a sink.
     float elapsed_time;
+    // How sure we are that the AI with more wins is the better one, from 0.5 (even) up to 1. For a match stopped early
+    // as even, how sure we are that neither is better instead. Never below stop_confidence when stopped early.
+    float confidence;
+    float stop_confidence;
     uint32_t games_per_match;
+    uint32_t games_played;
     uint8_t board_size;
+    bool stopped_early;
+    bool even; // NOTE(mattg): stopped early because neither AI is better, the match is a tie whatever its wins.
+    bool paired;
 } BShip_MatchData;
 
+// Gets every game of a match as soon as it is over, game_index counting up from 0. The game's ships and shots are
+// only valid during the call, they are rolled back out of the arena right after it.
+typedef void (*BShip_GameSinkProc)(void *data, uint32_t game_index, BShip_GameData *game);
+
+typedef struct {
+    BShip_GameSinkProc proc;
+    void *data;
+} BShip_GameSink;
+
+typedef struct BShip_AIPool BShip_AIPool;
+
 typedef enum {
     CONTEST_CLASSIC,
     CONTEST_ROUND_ROBIN,
 } BShip_ContestAlgorithm;
 
+typedef struct {
+    BShip_Error error;
+    char *path;
+    char *dir;
+    char *name;
+    char *authors;
+    uint32_t match_wins;
+    uint32_t match_losses;
+    uint32_t match_ties;
+    uint32_t wins;
+    uint32_t losses;
+    uint32_t ties;
+    int32_t last_bye_round;
+    uint8_t lives;
+    // NOTE(mattg): summed over the usage_match_count matches it was measured in, max_resident_kilobytes is the most.
+    BShip_AIUsage usage;
+    uint32_t usage_match_count;
+} BShip_ContestAIData;
+
+typedef struct {
+    BShip_ContestAIData *buffer;
+    uint32_t length;
+    uint32_t capacity;
+} BShip_ContestAIDataArray;
+
+typedef struct {
+    // NOTE(mattg): games are not kept for contest matches, only the per-AI match totals.
+    BShip_MatchData data;
+    uint32_t ai1_index;
+    uint32_t ai2_index;
+    uint32_t round;
+    BShip_GameResult ai1_result;
+    BShip_GameResult ai2_result;
+    // NOTE(mattg): the match couldn't be started (out of memory), so it wasn't played and counts for neither AI.
+    bool failed;
+} BShip_ContestMatch;
+
+typedef struct {
+    BShip_ContestMatch *buffer;
+    uint32_t length;
+    uint32_t capacity;
+} BShip_ContestMatchArray;
+
+typedef struct {
+    BShip_ContestAIDataArray ais;
+    BShip_ContestMatchArray matches;
+    float elapsed_time;
+    uint32_t rounds;
+    uint32_t thread_count;
+    uint32_t matches_per_thread;
+    uint32_t games_per_match;
+    float stop_confidence;
+    bool paired;
+    uint8_t board_size;
+    BShip_ContestAlgorithm algorithm;
+} BShip_ContestData;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -229,17 +387,61 @@ BShip_ArenaMark BShip_ArenaMark_Get(BShip_Arena *arena);
 void BShip_Arena_Rollback(BShip_Arena *arena, BShip_ArenaMark mark);
 
 BShip_Board BShip_Board_Allocate(BShip_Arena *arena, uint8_t board_size);
+BShip_PackedShip BShip_Ship_Pack(BShip_Ship ship);
+BShip_Ship BShip_Ship_Unpack(BShip_PackedShip ship);
+BShip_PackedShot BShip_Shot_Pack(BShip_Shot shot);
+BShip_Shot BShip_Shot_Unpack(BShip_PackedShot shot);
 BShip_BoardValue BShip_Board_Get(BShip_Board board, uint8_t row, uint8_t column);
 void BShip_Board_Set(BShip_Board board, uint8_t row, uint8_t column, BShip_BoardValue value);
 
-// void BShip_Contest_Run(char *socket_path, char *ai_paths[], uint32_t ai_paths_length,
-//     uint8_t board_size, uint32_t games_per_match, BShip_ContestAlgorithm algorithm, bool debug);
-
+// NOTE(mattg): keeps AIs that support it running between matches, see BShip_Match_Run. The pool keeps the path and
+// dir of every AI it holds, so they have to last as long as it does. Close it to stop all of them.
+// zygote_capacity is how many different AIs it can hold a zygote for, 0 never forks AIs from one.
+size_t BShip_AIPool_CalculateMemorySize(uint32_t capacity, uint32_t zygote_capacity);
+BShip_AIPool *BShip_AIPool_Create(BShip_Arena *arena, uint32_t capacity, uint32_t zygote_capacity);
+void BShip_AIPool_Close(BShip_AIPool *pool, bool debug);
+
+// NOTE(mattg): pass the same thread_count and matches_per_thread as to BShip_Contest_Run.
+size_t BShip_Contest_CalculateMemorySize(uint32_t ai_count, BShip_ContestAlgorithm algorithm, uint32_t thread_count,
+    uint32_t matches_per_thread);
+
+// NOTE(mattg): a NULL socket_path connects every AI through a socket pair instead of a named socket.
+// AIs then get "fd:3" instead of a socket path as their first argument, and must support it.
+// A thread_count of 0 uses one thread per processor, and each thread runs matches_per_thread matches at once.
+// See BShip_Match_Run for stop_confidence and paired.
+BShip_ContestData BShip_Contest_Run(BShip_Arena *arena, char *socket_path,
+    char *ai_paths[], char *ai_dirs[], uint32_t ai_count,
+    uint8_t board_size, uint32_t games_per_match, float stop_confidence, bool paired,
+    BShip_ContestAlgorithm algorithm, uint32_t thread_count, uint32_t matches_per_thread, bool debug);
+
+// NOTE(mattg): with a sink only one game is in the arena at a time, so pass 1 for games_per_match.
 size_t BShip_Match_CalculateMemorySize(uint8_t board_size, uint32_t games_per_match);
 
+// NOTE(mattg): see BShip_Contest_Run for what a NULL socket_path means.
+// A NULL sink keeps every game in the match's games, otherwise they are handed to the sink and not kept.
+// A stop_confidence between 0.5 and 1 (like 0.95) ends the match as soon as the winner is known to be better with
+// that confidence, or both AIs are known to be even (see BSHIP_MATCH_STOP_MARGIN), instead of playing all of
+// games_per_match. 0 always plays all of them.
+// A paired match plays its games in pairs with the same ship lengths, the second one with the seats swapped (the
+// AIs that support new matches, and plugins, are set up again as the other player). The winner is then whoever won
+// more pairs, and games_per_match has to be even.
+// With a pool, an AI that is already running in it is used instead of starting a new one, and AIs that support new
+// matches are left running in it afterwards. An AI that can be a zygote is forked from one in the pool instead, once
+// it has played a match. A NULL pool starts and stops both AIs.
 BShip_MatchData BShip_Match_Run(BShip_Arena *arena, char *socket_path,
     char *ai1_path, char *ai1_dir, char *ai2_path, char *ai2_dir,
-    uint8_t board_size, uint32_t games_per_match, bool debug);
+    uint8_t board_size, uint32_t games_per_match, float stop_confidence, bool paired,
+    BShip_GameSink *sink, BShip_AIPool *pool, bool debug);
+
+// Plays without any processes or messages, calling straight into the players (see battleshipsplayer.h), with the
+// same rules as a real match. Size the arena with BShip_Match_CalculateMemorySize.
+// NOTE(mattg): BShip_Game_Simulate doesn't set up the players, call their setup_match first (and match_over after).
+// Only the game's ships and shots are left in the arena, and if it ran out (or the arguments are bad) the ships
+// buffer is NULL.
+BShip_GameData BShip_Game_Simulate(BShip_Arena *arena, BShip_Player *ai1, BShip_Player *ai2, uint8_t board_size);
+
+BShip_MatchData BShip_Match_Simulate(BShip_Arena *arena, BShip_Player *ai1, BShip_Player *ai2,
+    uint8_t board_size, uint32_t games_per_match, float stop_confidence, bool paired, BShip_GameSink *sink);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,64 @@
+/**
+ * @file battleshipsplayer.h
+ * @author Matthew Getgen
+ * @brief Battleships in-process player (plugin) ABI.
+ * @date 2026-10-16
+ *
+ * A trusted AI can be built as a shared library instead of an executable, and is then played inside of the
+ * controller with plain function calls instead of messages. The calls line up with the PlayerV2 virtuals, and come
+ * in the same order the messages would.
+ *
+ * The library exports BSHIP_PLAYER_CREATE_SYMBOL, which fills in a BShip_Player. The same library can be loaded
+ * for both players of a match, so all of a player's state has to live in its own data, not in globals.
+ *
+ * Nothing in here depends on battleshipslib.h, so a C++ AI can include it as is. Ships and shots are single bytes
+ * per field like the binary messages, and the values are the same as BShip_Direction and BShip_BoardValue.
+ */
+
+#ifndef BATTLESHIPSPLAYER_H
+#define BATTLESHIPSPLAYER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// NOTE(mattg): bump this whenever BShip_Player changes, a library built against another version is refused.
+#define BSHIP_PLAYER_ABI_VERSION 1
+#define BSHIP_PLAYER_CREATE_SYMBOL "BShip_Player_Create"
+// NOTE(mattg): an AI path ending in this is loaded as a plugin instead of started as a process.
+#define BSHIP_PLAYER_PLUGIN_SUFFIX ".so"
+
+typedef struct {
+    uint8_t row;
+    uint8_t column;
+    uint8_t length;
+    uint8_t direction;
+} BShip_PlayerShip;
+
+typedef struct {
+    uint8_t row;
+    uint8_t column;
+    uint8_t value;
+} BShip_PlayerShot;
+
+typedef struct {
+    void *data;
+    const char *name;
+    const char *authors;
+    // player is 1 or 2.
+    void (*setup_match)(void *data, uint8_t player, uint8_t board_size);
+    void (*start_game)(void *data);
+    // fills in one ship for each of the count lengths.
+    void (*choose_ship_placements)(void *data, const uint8_t *lengths, uint8_t count, BShip_PlayerShip *ships);
+    BShip_PlayerShot (*choose_shot)(void *data);
+    // called for both players' shots, then for the ship that died for each player (if one did).
+    void (*handle_shot_result)(void *data, uint8_t player, BShip_PlayerShot shot);
+    void (*handle_ship_dead)(void *data, uint8_t player, BShip_PlayerShip ship);
+    void (*handle_game_over)(void *data);
+    void (*handle_match_over)(void *data);
+    void (*destroy)(void *data);
+} BShip_Player;
+
+// Returns false if the player couldn't be created, or doesn't support abi_version.
+typedef bool (*BShip_Player_CreateProc)(BShip_Player *player, uint32_t abi_version);
+
+#endif // BATTLESHIPSPLAYER_H
@@ -3,6 +3,8 @@
 set -e
 
 MODE="${1:-debug}"
+# NOTE(mattg): which file in platforms/ to build, unix (epoll/poll) or linux_uring (io_uring, Linux 5.19+).
+PLATFORM="${2:-unix}"
 
 BUILD_DIR="build"
 
@@ -22,11 +24,21 @@ DEBUG_FLAGS=(
     -fsanitize=undefined
 )
 
+# NOTE(mattg): asserts are for debug builds, the hot paths check every board access with them.
 RELEASE_FLAGS=(
     -Werror
     -O3
     -march=native
     -flto
+    -DNDEBUG
+)
+
+# NOTE(mattg): optimized like release, but with gcc and symbols, so perf and the bench build work anywhere.
+BENCH_FLAGS=(
+    -O3
+    -march=native
+    -g
+    -DNDEBUG
 )
 
 case "$MODE" in
@@ -40,12 +52,22 @@ case "$MODE" in
         CFLAGS=("${COMMON_FLAGS[@]}" "${RELEASE_FLAGS[@]}")
         YYJSON_OBJ="$BUILD_DIR/yyjson_release.o"
         ;;
+    bench)
+        CC=gcc
+        CFLAGS=("${COMMON_FLAGS[@]}" "${BENCH_FLAGS[@]}")
+        YYJSON_OBJ="$BUILD_DIR/yyjson_bench.o"
+        ;;
     *)
-        echo "Usage: $0 [debug|release]"
+        echo "Usage: $0 [debug|release|bench] [unix|linux_uring]"
         exit 1
         ;;
 esac
 
+if [ ! -f "platforms/$PLATFORM.c" ]; then
+    echo "Usage: $0 [debug|release|bench] [unix|linux_uring]"
+    exit 1
+fi
+
 # NOTE(mattg): Because yyjson is slow to compile (~10s), just compile it if the object isn't there
 if [ ! -f "$YYJSON_OBJ" ]; then
     echo "Compiling yyjson.c $MODE object..."
@@ -58,7 +80,7 @@ if [ ! -f "$YYJSON_OBJ" ]; then
         -o "$YYJSON_OBJ"
 fi
 
-SRC="platforms/unix.c runtime.c"
+SRC="platforms/$PLATFORM.c runtime.c"
 OBJ="$YYJSON_OBJ"
 
 
@@ -72,4 +94,6 @@ for file in $SRC; do
 done
 
 echo "archiving ${OBJ} into battleshipslib.a..."
+# NOTE(mattg): start over, so an object from the other platform doesn't stick around in the archive.
+rm -f battleshipslib.a
 ar rcs battleshipslib.a $OBJ
@@ -3,5 +3,655 @@
  * @author Matthew Getgen
  * @brief Logic for running a contest.
  * @date 2026-05-12
+ *
+ * Matches in a contest (every match of a round robin, or every match of a classic round) are independent,
+ * so they are handed out to a pool of worker threads. Each worker owns its own arena and socket, and stores
+ * the result of a match into the slot the match was scheduled in, so the contest result is the same
+ * no matter which worker ran which match.
+ *
+ * A worker doesn't run its matches one after the other either. It keeps a few of them going at once on a single
+ * reactor, so while one match waits on its AIs to think, the others can move forward.
  */
 
+#include "battleshipslib.h"
+
+#define BSHIP_CONTEST_SOCKET_SUFFIX_SIZE 16
+// NOTE(mattg): room for both AIs of every match a worker runs at once, and as many more waiting for their next one.
+#define BSHIP_CONTEST_POOL_SIZE_PER_MATCH 4
+
+typedef struct {
+    BShip_Arena *arena; // NOTE(mattg): shared by all workers, only use it while holding the mutex.
+    BShip_Mutex *mutex;
+    BShip_ContestData *contest;
+    BShip_ContestMatch *jobs;
+    uint32_t job_count;
+    uint32_t job_next;
+    bool debug;
+} BShip_ContestQueue;
+
+typedef struct {
+    BShip_Arena arena; // NOTE(mattg): matches finish in any order, so every one of them needs its own arena.
+    char *socket_path;
+    BShip_ContestMatch *match;
+    BShip_MatchState *state;
+    // NOTE(mattg): the games go through a sink, so the arena only ever holds the one being played.
+    BShip_GameSink sink;
+    BShip_ErrorType ai1_game_error;
+    BShip_ErrorType ai2_game_error;
+} BShip_ContestSlot;
+
+typedef struct {
+    BShip_ContestQueue *queue;
+    BShip_AIPool *pool; // NOTE(mattg): kept for the whole contest, so AIs can be reused across rounds too.
+    BShip_Reactor *reactor;
+    BShip_ReactorEvent *events;
+    BShip_ContestSlot *slots;
+    uint32_t slot_count;
+} BShip_ContestWorker;
+
+static uint32_t ContestMatch_GetCapacity(uint32_t ai_count, BShip_ContestAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case CONTEST_CLASSIC:
+        // NOTE(mattg): every classic match takes at least one life, so there can't be more matches than lives.
+        return ai_count * BSHIP_CONTEST_LIVES_MAX;
+    case CONTEST_ROUND_ROBIN:
+        return (ai_count * (ai_count - 1)) / 2;
+    }
+    return 0;
+}
+
+// Fills in the defaults for a thread_count or matches_per_thread of 0, and keeps both under their max.
+static void Contest_GetThreadCounts(uint32_t *thread_count, uint32_t *matches_per_thread)
+{
+    if (*thread_count == 0)
+    {
+        *thread_count = BShip_Processor_GetCount();
+    }
+    if (*thread_count > BSHIP_CONTEST_THREAD_COUNT_MAX)
+    {
+        *thread_count = BSHIP_CONTEST_THREAD_COUNT_MAX;
+    }
+    if (*matches_per_thread == 0)
+    {
+        *matches_per_thread = 1;
+    }
+    if (*matches_per_thread > BSHIP_CONTEST_MATCHES_PER_THREAD_MAX)
+    {
+        *matches_per_thread = BSHIP_CONTEST_MATCHES_PER_THREAD_MAX;
+    }
+}
+
+size_t BShip_Contest_CalculateMemorySize(uint32_t ai_count, BShip_ContestAlgorithm algorithm, uint32_t thread_count,
+    uint32_t matches_per_thread)
+{
+    Contest_GetThreadCounts(&thread_count, &matches_per_thread);
+    size_t ai_size = sizeof(BShip_ContestAIData) + (BSHIP_MESSAGE_NAME_SIZE_MAX * 2) + sizeof(uint32_t);
+    size_t match_size = sizeof(BShip_ContestMatch);
+    uint32_t event_capacity = matches_per_thread * 2;
+    // NOTE(mattg): this doesn't count the matches themselves, the arena grows for those.
+    size_t worker_size = sizeof(BShip_ContestWorker) + BShip_Thread_GetSize()
+        + ((sizeof(BShip_ContestSlot) + BSHIP_MESSAGE_SIZE) * matches_per_thread)
+        + BShip_Reactor_GetSize(event_capacity) + (sizeof(BShip_ReactorEvent) * event_capacity)
+        + BShip_AIPool_CalculateMemorySize(matches_per_thread * BSHIP_CONTEST_POOL_SIZE_PER_MATCH, ai_count);
+    return (ai_size * ai_count) + (match_size * ContestMatch_GetCapacity(ai_count, algorithm))
+        + (worker_size * thread_count) + sizeof(BShip_ContestQueue) + BShip_Mutex_GetSize();
+}
+
+static void ContestSlot_StoreGame(void *data, uint32_t game_index, BShip_GameData *game)
+{
+    (void)game_index;
+    BShip_ContestSlot *slot = data;
+    // NOTE(mattg): a game with an error is always the last one of the match.
+    slot->ai1_game_error = game->ai1.error.type;
+    slot->ai2_game_error = game->ai2.error.type;
+}
+
+static void ContestAI_AddUsage(BShip_ContestAIData *ai, BShip_AIUsage usage)
+{
+    if (!usage.measured)
+    {
+        return;
+    }
+    ai->usage.user_seconds += usage.user_seconds;
+    ai->usage.system_seconds += usage.system_seconds;
+    if (usage.max_resident_kilobytes > ai->usage.max_resident_kilobytes)
+    {
+        ai->usage.max_resident_kilobytes = usage.max_resident_kilobytes;
+    }
+    ai->usage.voluntary_context_switches += usage.voluntary_context_switches;
+    ai->usage.involuntary_context_switches += usage.involuntary_context_switches;
+    ai->usage.measured = true;
+    ai->usage_match_count++;
+}
+
+static void ContestMatch_Store(BShip_ContestQueue *queue, BShip_ContestSlot *slot, BShip_MatchData data)
+{
+    BShip_ContestMatch *match = slot->match;
+    // NOTE(mattg): a paired match is won by winning more pairs.
+    uint32_t ai1_wins = data.paired ? data.ai1.pair_wins : data.ai1.wins;
+    uint32_t ai2_wins = data.paired ? data.ai2.pair_wins : data.ai2.wins;
+
+    // NOTE(mattg): errors that happen during a game are only stored on that game, bring them up to the match.
+    if (data.ai1.error.type == ERROR_SUCCESS)
+    {
+        data.ai1.error.type = slot->ai1_game_error;
+    }
+    if (data.ai2.error.type == ERROR_SUCCESS)
+    {
+        data.ai2.error.type = slot->ai2_game_error;
+    }
+
+    bool ai1_error = data.ai1.error.type != ERROR_SUCCESS;
+    bool ai2_error = data.ai2.error.type != ERROR_SUCCESS;
+    if (ai1_error != ai2_error)
+    {
+        match->ai1_result = ai1_error ? BSHIP_LOSS : BSHIP_WIN;
+    }
+    else if (ai1_wins != ai2_wins && !data.even)
+    {
+        match->ai1_result = ai1_wins > ai2_wins ? BSHIP_WIN : BSHIP_LOSS;
+    }
+    else
+    {
+        match->ai1_result = BSHIP_TIE;
+    }
+    match->ai2_result = match->ai1_result == BSHIP_TIE ? BSHIP_TIE
+        : (match->ai1_result == BSHIP_WIN ? BSHIP_LOSS : BSHIP_WIN);
+
+    BShip_Mutex_Lock(queue->mutex);
+    {
+        BShip_ContestData *contest = queue->contest;
+        struct {
+            BShip_ContestAIData *ai;
+            BShip_AIMatchData *data;
+            BShip_GameResult result;
+        } sides[] = {
+            { &contest->ais.buffer[match->ai1_index], &data.ai1, match->ai1_result },
+            { &contest->ais.buffer[match->ai2_index], &data.ai2, match->ai2_result },
+        };
+        for (size_t i = 0; i < (sizeof(sides) / sizeof(sides[0])); i++)
+        {
+            BShip_ContestAIData *ai = sides[i].ai;
+            BShip_AIMatchData *ai_data = sides[i].data;
+
+            // NOTE(mattg): the name stays empty when the AI's hello wasn't read (like when its opponent never sent
+            // one), so it's filled in by the first match that has it. Every match shares the buffer, so the ones
+            // stored before then get it too.
+            bool named = ai_data->name != NULL && ai_data->authors != NULL && ai_data->name[0] != '\0';
+            if (ai->name == NULL)
+            {
+                ai->name = BSHIP_ARENA_PUSH_ARRAY(queue->arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+                ai->authors = BSHIP_ARENA_PUSH_ARRAY(queue->arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+                if (ai->name != NULL && ai->authors != NULL)
+                {
+                    ai->name[0] = '\0';
+                    ai->authors[0] = '\0';
+                }
+            }
+            if (named && ai->name != NULL && ai->authors != NULL && ai->name[0] == '\0')
+            {
+                memcpy(ai->name, ai_data->name, BSHIP_MESSAGE_NAME_SIZE_MAX);
+                memcpy(ai->authors, ai_data->authors, BSHIP_MESSAGE_NAME_SIZE_MAX);
+            }
+            // NOTE(mattg): everything else in the match points into the worker's arena, which is about to be reused.
+            ai_data->name = ai->name;
+            ai_data->authors = ai->authors;
+            ai_data->error.message = (BShip_Message){0};
+
+            ai->wins += ai_data->wins;
+            ai->losses += ai_data->losses;
+            ai->ties += ai_data->ties;
+            ContestAI_AddUsage(ai, ai_data->usage);
+            switch (sides[i].result)
+            {
+            case BSHIP_WIN:
+                ai->match_wins++;
+                break;
+            case BSHIP_LOSS:
+                ai->match_losses++;
+                break;
+            case BSHIP_TIE:
+                ai->match_ties++;
+                break;
+            }
+
+            if (contest->algorithm == CONTEST_CLASSIC)
+            {
+                if (ai_data->error.type != ERROR_SUCCESS)
+                {
+                    ai->lives = 0;
+                }
+                else if (sides[i].result != BSHIP_WIN && ai->lives > 0)
+                {
+                    ai->lives--;
+                }
+            }
+            if (ai_data->error.type != ERROR_SUCCESS)
+            {
+                ai->error = ai_data->error;
+            }
+        }
+        data.games = (BShip_GameDataArray){0};
+        match->data = data;
+    }
+    BShip_Mutex_Unlock(queue->mutex);
+}
+
+static BShip_ContestMatch *ContestQueue_Next(BShip_ContestQueue *queue)
+{
+    BShip_ContestMatch *match = NULL;
+    BShip_Mutex_Lock(queue->mutex);
+    if (queue->job_next < queue->job_count)
+    {
+        match = &queue->jobs[queue->job_next];
+        queue->job_next++;
+    }
+    BShip_Mutex_Unlock(queue->mutex);
+    return match;
+}
+
+static void ContestWorker_Run(void *data)
+{
+    BShip_ContestWorker *worker = data;
+    BShip_ContestQueue *queue = worker->queue;
+    BShip_ContestData *contest = queue->contest;
+    uint32_t event_capacity = worker->slot_count * 2;
+    bool drained = false;
+
+    for (;;)
+    {
+        uint32_t running = 0;
+        bool finished = false;
+        for (uint32_t i = 0; i < worker->slot_count; i++)
+        {
+            BShip_ContestSlot *slot = &worker->slots[i];
+            if (slot->match == NULL && !drained)
+            {
+                slot->match = ContestQueue_Next(queue);
+                if (slot->match == NULL)
+                {
+                    drained = true;
+                }
+                else
+                {
+                    BShip_ContestAIData *ai1 = &contest->ais.buffer[slot->match->ai1_index];
+                    BShip_ContestAIData *ai2 = &contest->ais.buffer[slot->match->ai2_index];
+                    slot->ai1_game_error = slot->ai2_game_error = ERROR_SUCCESS;
+                    slot->state = Match_Start(&slot->arena, worker->reactor, slot->socket_path,
+                        ai1->path, ai1->dir, ai2->path, ai2->dir, contest->board_size,
+                        contest->games_per_match, contest->stop_confidence, contest->paired, &slot->sink,
+                        worker->pool, queue->debug);
+                }
+            }
+            if (slot->match == NULL)
+            {
+                continue;
+            }
+
+            if (slot->state == NULL)
+            {
+                PRINT_ERROR("Contest match could not be started!");
+                slot->match->ai1_result = slot->match->ai2_result = BSHIP_TIE;
+                slot->match->failed = true;
+            }
+            else
+            {
+                Match_Advance(worker->reactor, slot->state);
+                if (slot->state->step != MATCH_STEP_DONE)
+                {
+                    running++;
+                    continue;
+                }
+                ContestMatch_Store(queue, slot, Match_Finish(worker->reactor, slot->state));
+            }
+            BShip_Arena_Reset(&slot->arena);
+            slot->match = NULL;
+            slot->state = NULL;
+            finished = true;
+        }
+        if (finished && !drained)
+        {
+            // NOTE(mattg): refill the slots that just opened up before waiting.
+            continue;
+        }
+        if (running == 0)
+        {
+            if (drained)
+            {
+                break;
+            }
+            continue;
+        }
+
+        int32_t count = BShip_Reactor_Wait(worker->reactor, worker->events, event_capacity);
+        if (count < 0)
+        {
+            for (uint32_t i = 0; i < worker->slot_count; i++)
+            {
+                if (worker->slots[i].state != NULL)
+                {
+                    Match_OnWaitFailed(worker->slots[i].state);
+                }
+            }
+            continue;
+        }
+        for (int32_t i = 0; i < count; i++)
+        {
+            Match_OnEvent(worker->events[i].data, worker->events[i]);
+        }
+    }
+}
+
+static void Contest_RunMatches(BShip_ContestQueue *queue, BShip_ContestWorker *workers, uint8_t *threads,
+    uint32_t thread_count, BShip_ContestMatch *jobs, uint32_t job_count)
+{
+    queue->jobs = jobs;
+    queue->job_count = job_count;
+    queue->job_next = 0;
+
+    if (thread_count > job_count)
+    {
+        thread_count = job_count;
+    }
+    size_t thread_size = BShip_Thread_GetSize();
+    uint32_t started = 0;
+    for (; started < thread_count; started++)
+    {
+        BShip_Thread *thread = (BShip_Thread *)&threads[started * thread_size];
+        if (!BShip_Thread_Start(thread, ContestWorker_Run, &workers[started]))
+        {
+            break;
+        }
+    }
+    if (started == 0)
+    {
+        // NOTE(mattg): no threads could be started, so just run the matches on this one.
+        ContestWorker_Run(&workers[0]);
+    }
+    for (uint32_t i = 0; i < started; i++)
+    {
+        BShip_Thread_Join((BShip_Thread *)&threads[i * thread_size]);
+    }
+}
+
+static void Contest_RunRoundRobin(BShip_ContestQueue *queue, BShip_ContestWorker *workers, uint8_t *threads,
+    uint32_t thread_count)
+{
+    BShip_ContestData *contest = queue->contest;
+    // NOTE(mattg): an AI that was turned away at the start doesn't get any matches, like in a classic contest.
+    for (uint32_t i = 0; i < contest->ais.length; i++)
+    {
+        if (contest->ais.buffer[i].error.type != ERROR_SUCCESS)
+        {
+            continue;
+        }
+        for (uint32_t j = i + 1; j < contest->ais.length; j++)
+        {
+            if (contest->ais.buffer[j].error.type != ERROR_SUCCESS)
+            {
+                continue;
+            }
+            assert(contest->matches.length < contest->matches.capacity);
+            BShip_ContestMatch *match = &contest->matches.buffer[contest->matches.length++];
+            memset(match, 0, sizeof(BShip_ContestMatch));
+            match->ai1_index = i;
+            match->ai2_index = j;
+            match->round = 1;
+        }
+    }
+    contest->rounds = 1;
+    Contest_RunMatches(queue, workers, threads, thread_count, contest->matches.buffer, contest->matches.length);
+}
+
+static void Contest_RunClassic(BShip_ContestQueue *queue, BShip_ContestWorker *workers, uint8_t *threads,
+    uint32_t thread_count)
+{
+    BShip_ContestData *contest = queue->contest;
+    uint32_t *round_ais = BSHIP_ARENA_PUSH_ARRAY(queue->arena, uint32_t, contest->ais.length);
+    if (round_ais == NULL)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        uint32_t round_ai_count = 0;
+        for (uint32_t i = 0; i < contest->ais.length; i++)
+        {
+            if (contest->ais.buffer[i].lives > 0)
+            {
+                round_ais[round_ai_count++] = i;
+            }
+        }
+        if (round_ai_count <= 1)
+        {
+            break;
+        }
+        uint32_t round = contest->rounds + 1;
+
+        // an odd number of AIs means one of them gets a bye, chosen from the ones who had a bye the longest ago.
+        if (round_ai_count % 2 == 1)
+        {
+            int32_t oldest_bye_round = contest->ais.buffer[round_ais[0]].last_bye_round;
+            uint32_t choice_count = 0;
+            for (uint32_t i = 0; i < round_ai_count; i++)
+            {
+                int32_t bye_round = contest->ais.buffer[round_ais[i]].last_bye_round;
+                if (bye_round < oldest_bye_round)
+                {
+                    oldest_bye_round = bye_round;
+                    choice_count = 0;
+                }
+                if (bye_round == oldest_bye_round)
+                {
+                    choice_count++;
+                }
+            }
+            uint32_t choice = (uint32_t)rand() % choice_count;
+            for (uint32_t i = 0; i < round_ai_count; i++)
+            {
+                if (contest->ais.buffer[round_ais[i]].last_bye_round != oldest_bye_round)
+                {
+                    continue;
+                }
+                if (choice == 0)
+                {
+                    contest->ais.buffer[round_ais[i]].last_bye_round = (int32_t)round;
+                    round_ais[i] = round_ais[--round_ai_count];
+                    break;
+                }
+                choice--;
+            }
+        }
+
+        uint32_t match_count = round_ai_count / 2;
+        if (contest->matches.length + match_count > contest->matches.capacity)
+        {
+            break;
+        }
+        BShip_ContestMatch *round_matches = &contest->matches.buffer[contest->matches.length];
+        for (uint32_t i = 0; i < match_count; i++)
+        {
+            BShip_ContestMatch *match = &contest->matches.buffer[contest->matches.length++];
+            memset(match, 0, sizeof(BShip_ContestMatch));
+            match->round = round;
+
+            uint32_t choice = (uint32_t)rand() % round_ai_count;
+            match->ai1_index = round_ais[choice];
+            round_ais[choice] = round_ais[--round_ai_count];
+
+            choice = (uint32_t)rand() % round_ai_count;
+            match->ai2_index = round_ais[choice];
+            round_ais[choice] = round_ais[--round_ai_count];
+        }
+        contest->rounds = round;
+        Contest_RunMatches(queue, workers, threads, thread_count, round_matches, match_count);
+    }
+}
+
+BShip_ContestData BShip_Contest_Run(BShip_Arena *arena, char *socket_path,
+    char *ai_paths[], char *ai_dirs[], uint32_t ai_count,
+    uint8_t board_size, uint32_t games_per_match, float stop_confidence, bool paired,
+    BShip_ContestAlgorithm algorithm, uint32_t thread_count, uint32_t matches_per_thread, bool debug)
+{
+    BShip_ContestData contest = {0};
+    if (arena == NULL || ai_paths == NULL || ai_dirs == NULL)
+    {
+        return contest;
+    }
+    else if (ai_count < BSHIP_CONTEST_AI_COUNT_MIN)
+    {
+        return contest;
+    }
+    else if (board_size < BSHIP_BOARD_SIZE_MIN || board_size > BSHIP_BOARD_SIZE_MAX)
+    {
+        return contest;
+    }
+    else if (games_per_match < BSHIP_GAMES_PER_MATCH_MIN || games_per_match > BSHIP_GAMES_PER_MATCH_MAX)
+    {
+        return contest;
+    }
+    else if (stop_confidence != 0.0f && (stop_confidence <= 0.5f || stop_confidence >= 1.0f))
+    {
+        return contest;
+    }
+    else if (paired && games_per_match % 2 != 0)
+    {
+        return contest;
+    }
+    double start_time = BShip_Time_GetSeconds();
+
+    Contest_GetThreadCounts(&thread_count, &matches_per_thread);
+    contest.thread_count = thread_count;
+    contest.matches_per_thread = matches_per_thread;
+    contest.games_per_match = games_per_match;
+    contest.stop_confidence = stop_confidence;
+    contest.paired = paired;
+    contest.board_size = board_size;
+    contest.algorithm = algorithm;
+
+    contest.ais.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_ContestAIData, ai_count);
+    contest.ais.capacity = ai_count;
+    contest.matches.capacity = ContestMatch_GetCapacity(ai_count, algorithm);
+    contest.matches.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_ContestMatch, contest.matches.capacity);
+    if (contest.ais.buffer == NULL || contest.matches.buffer == NULL)
+    {
+        return contest;
+    }
+    for (contest.ais.length = 0; contest.ais.length < contest.ais.capacity; contest.ais.length++)
+    {
+        BShip_ContestAIData *ai = &contest.ais.buffer[contest.ais.length];
+        memset(ai, 0, sizeof(BShip_ContestAIData));
+        ai->path = ai_paths[contest.ais.length];
+        ai->dir = ai_dirs[contest.ais.length];
+        ai->lives = BSHIP_CONTEST_LIVES_MAX;
+        ai->last_bye_round = -1;
+        if (ai->path == NULL || ai->dir == NULL ||
+            !BShip_PathIsExecutable(ai->path) || !BShip_PathIsDirectory(ai->dir))
+        {
+            PRINT_ERROR_F("AI %s will not participate in the contest.", ai->path == NULL ? "(null)" : ai->path);
+            ai->error.type = ERROR_AI_PATH_ISSUE;
+            ai->lives = 0;
+        }
+    }
+
+    BShip_ContestQueue queue = {
+        .arena = arena,
+        .mutex = BShip_Arena_Push(arena, BShip_Mutex_GetSize()),
+        .contest = &contest,
+        .debug = debug,
+    };
+    BShip_ContestWorker *workers = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_ContestWorker, thread_count);
+    uint8_t *threads = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, BShip_Thread_GetSize() * thread_count);
+    if (queue.mutex == NULL || workers == NULL || threads == NULL)
+    {
+        return contest;
+    }
+    if (!BShip_Mutex_Initialize(queue.mutex))
+    {
+        return contest;
+    }
+
+    size_t socket_path_size = socket_path == NULL ? 0 : strlen(socket_path) + BSHIP_CONTEST_SOCKET_SUFFIX_SIZE;
+    // NOTE(mattg): the slots hand their games to a sink, so a match needs the same memory for any number of games.
+    size_t match_memory_size = BShip_Match_CalculateMemorySize(board_size, 1);
+    uint32_t event_capacity = matches_per_thread * 2;
+    uint32_t worker_count = 0;
+    for (; worker_count < thread_count; worker_count++)
+    {
+        BShip_ContestWorker *worker = &workers[worker_count];
+        worker->queue = &queue;
+        worker->slot_count = 0;
+        // NOTE(mattg): room for a zygote of every AI, so the ones that can be one are only initialized once per worker.
+        worker->pool = BShip_AIPool_Create(arena, matches_per_thread * BSHIP_CONTEST_POOL_SIZE_PER_MATCH, ai_count);
+        worker->reactor = BShip_Arena_Push(arena, BShip_Reactor_GetSize(event_capacity));
+        worker->events = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_ReactorEvent, event_capacity);
+        worker->slots = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_ContestSlot, matches_per_thread);
+        if (worker->pool == NULL || worker->reactor == NULL || worker->events == NULL || worker->slots == NULL)
+        {
+            break;
+        }
+        if (!BShip_Reactor_Create(worker->reactor, event_capacity))
+        {
+            break;
+        }
+        for (; worker->slot_count < matches_per_thread; worker->slot_count++)
+        {
+            BShip_ContestSlot *slot = &worker->slots[worker->slot_count];
+            memset(slot, 0, sizeof(BShip_ContestSlot));
+            slot->sink.proc = ContestSlot_StoreGame;
+            slot->sink.data = slot;
+            // NOTE(mattg): every match needs its own socket, or the AIs of two matches could connect to each
+            // other's. Socket pairs (a NULL socket_path) don't have that problem.
+            if (socket_path != NULL)
+            {
+                slot->socket_path = BSHIP_ARENA_PUSH_ARRAY(arena, char, socket_path_size);
+                if (slot->socket_path == NULL)
+                {
+                    break;
+                }
+                snprintf(slot->socket_path, socket_path_size, "%s.%u.%u",
+                    socket_path, worker_count, worker->slot_count);
+            }
+            BShip_Arena_Initialize(&slot->arena, match_memory_size);
+            if (slot->arena.first == NULL)
+            {
+                break;
+            }
+        }
+        if (worker->slot_count == 0)
+        {
+            BShip_Reactor_Close(worker->reactor);
+            break;
+        }
+    }
+
+    if (worker_count > 0)
+    {
+        switch (algorithm)
+        {
+        case CONTEST_CLASSIC:
+            Contest_RunClassic(&queue, workers, threads, worker_count);
+            break;
+        case CONTEST_ROUND_ROBIN:
+            Contest_RunRoundRobin(&queue, workers, threads, worker_count);
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        BShip_AIPool_Close(workers[i].pool, debug);
+        for (uint32_t j = 0; j < workers[i].slot_count; j++)
+        {
+            BShip_Arena_Destroy(&workers[i].slots[j].arena);
+        }
+        BShip_Reactor_Close(workers[i].reactor);
+    }
+    BShip_Mutex_Destroy(queue.mutex);
+
+    contest.elapsed_time = (float)(BShip_Time_GetSeconds() - start_time);
+    return contest;
+}
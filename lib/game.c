@@ -10,6 +10,28 @@
 
 #include "battleshipslib.h"
 
+// NOTE(mattg): everything a single game works on. The memory is handed in by whoever runs the game.
+typedef struct {
+    BShip_GameData data;
+    BShip_Board ai1_board;
+    BShip_Board ai2_board;
+    BShip_U8Array ship_lengths;
+    BShip_U8Array ship_lengths_copy;
+    // NOTE(mattg): the game is played on these, only the packed copies in data are kept.
+    BShip_ShipArray ai1_ships;
+    BShip_ShipArray ai2_ships;
+    BShip_Shot ai1_shot;
+    BShip_Shot ai2_shot;
+    // NOTE(mattg): ai2 sits in player 1's seat, so in process it is called first and is told about its own shots
+    // first. Only the seats change, not whose data is whose.
+    bool seats_swapped;
+    BShip_ArenaMark data_mark; // NOTE(mattg): before the ships and shots, a sink rolls back to here.
+    BShip_ArenaMark mark;
+    uint32_t shot_index;
+    uint32_t shot_count_max;
+    bool next_shot;
+} BShip_GameState;
+
 uint8_t ShipCountMin_From_BoardSize(uint8_t board_size)
 {
     assert(board_size >= BSHIP_BOARD_SIZE_MIN);
@@ -46,50 +68,295 @@ uint8_t ShipLengthMax_From_BoardSize(uint8_t board_size)
     return ship_length_max;
 }
 
+// NOTE(mattg): the ship rules only depend on the board size, which is fixed for a whole match and only ever 5 to 15,
+// so the formulas above are worked out ahead of time for every size instead of on every game:
+// X(board_size, ship_count_min, ship_count_max, ship_length_min, ship_length_max)
+#define BSHIP_BOARD_RULES_TABLE(X) \
+    X(5, 3, 3, 3, 3) \
+    X(6, 4, 5, 4, 3) \
+    X(7, 5, 6, 4, 4) \
+    X(8, 5, 7, 5, 4) \
+    X(9, 6, 8, 5, 5) \
+    X(10, 6, 8, 5, 5) \
+    X(11, 6, 9, 6, 5) \
+    X(12, 7, 9, 6, 5) \
+    X(13, 7, 9, 6, 5) \
+    X(14, 7, 10, 6, 6) \
+    X(15, 7, 10, 6, 6)
+
+#define BSHIP_BOARD_RULES_ENTRY(size, count_min, count_max, length_min, length_max) \
+    { \
+        .board_size = size, \
+        .ship_count_min = count_min, \
+        .ship_count_max = count_max, \
+        .ship_length_min = length_min, \
+        .ship_length_max = length_max, \
+        .shot_count_max = (size) * (size), \
+    },
+
+typedef struct {
+    uint8_t board_size;
+    uint8_t ship_count_min;
+    uint8_t ship_count_max;
+    uint8_t ship_length_min;
+    uint8_t ship_length_max;
+    uint8_t shot_count_max;
+} BShip_BoardRules;
+
+static const BShip_BoardRules BoardRules_Table[] = {
+    BSHIP_BOARD_RULES_TABLE(BSHIP_BOARD_RULES_ENTRY)
+};
+
+// Look this up once per match, and hand it to everything that needs the ship rules.
+const BShip_BoardRules *BoardRules_Get(uint8_t board_size)
+{
+    assert(board_size >= BSHIP_BOARD_SIZE_MIN);
+    assert(board_size <= BSHIP_BOARD_SIZE_MAX);
+    assert((sizeof(BoardRules_Table) / sizeof(BoardRules_Table[0])) ==
+        (BSHIP_BOARD_SIZE_MAX - BSHIP_BOARD_SIZE_MIN + 1));
+    const BShip_BoardRules *rules = &BoardRules_Table[board_size - BSHIP_BOARD_SIZE_MIN];
+    // NOTE(mattg): debug builds make sure the table didn't drift from the formulas.
+    assert(rules->board_size == board_size);
+    assert(rules->ship_count_min == ShipCountMin_From_BoardSize(board_size));
+    assert(rules->ship_count_max == ShipCountMax_From_BoardSize(board_size));
+    assert(rules->ship_length_min == ShipLengthMin_From_BoardSize(board_size));
+    assert(rules->ship_length_max == ShipLengthMax_From_BoardSize(board_size));
+    return rules;
+}
+
+static inline uint32_t Board_Index(uint8_t row, uint8_t column)
+{
+    return ((uint32_t)row * BSHIP_BOARD_ROW_BITS) + column;
+}
+
+static inline bool BoardMask_Test(const BShip_BoardMask *mask, uint32_t index)
+{
+    return (mask->words[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void BoardMask_Set(BShip_BoardMask *mask, uint32_t index)
+{
+    mask->words[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+
+static inline void BoardMask_Clear(BShip_BoardMask *mask, uint32_t index)
+{
+    mask->words[index >> 6] &= ~((uint64_t)1 << (index & 63));
+}
+
+static inline void BoardMask_Or(BShip_BoardMask *into, const BShip_BoardMask *mask)
+{
+    for (uint32_t i = 0; i < BSHIP_BOARD_WORD_COUNT; i++)
+    {
+        into->words[i] |= mask->words[i];
+    }
+}
+
+static inline bool BoardMask_Intersects(const BShip_BoardMask *a, const BShip_BoardMask *b)
+{
+    uint64_t both = 0;
+    for (uint32_t i = 0; i < BSHIP_BOARD_WORD_COUNT; i++)
+    {
+        both |= a->words[i] & b->words[i];
+    }
+    return both != 0;
+}
+
+// Whether every square in mask is also in of.
+static inline bool BoardMask_IsSubset(const BShip_BoardMask *mask, const BShip_BoardMask *of)
+{
+    uint64_t missing = 0;
+    for (uint32_t i = 0; i < BSHIP_BOARD_WORD_COUNT; i++)
+    {
+        missing |= mask->words[i] & ~of->words[i];
+    }
+    return missing == 0;
+}
+
+// NOTE(mattg): the ship has to already be known to fit on the board.
+static BShip_BoardMask BoardMask_From_Ship(BShip_Ship ship)
+{
+    BShip_BoardMask mask = {0};
+    uint32_t index = Board_Index(ship.row, ship.column);
+    if (ship.direction == BSHIP_HORIZONTAL)
+    {
+        mask.words[index >> 6] = (((uint64_t)1 << ship.length) - 1) << (index & 63);
+        return mask;
+    }
+    for (uint8_t i = 0; i < ship.length; i++, index += BSHIP_BOARD_ROW_BITS)
+    {
+        BoardMask_Set(&mask, index);
+    }
+    return mask;
+}
+
 BShip_BoardValue BShip_Board_Get(BShip_Board board, uint8_t row, uint8_t column)
 {
-    assert(board.buffer != NULL);
+    assert(board.planes != NULL);
     assert(board.size >= BSHIP_BOARD_SIZE_MIN);
     assert(board.size <= BSHIP_BOARD_SIZE_MAX);
     assert(row < board.size);
     assert(column < board.size);
-    uint32_t index = (row * board.size) + column;
-    return (BShip_BoardValue)board.buffer[index];
+    uint32_t index = Board_Index(row, column);
+    if (BoardMask_Test(&board.planes->kills, index))
+    {
+        return BSHIP_KILL;
+    }
+    else if (BoardMask_Test(&board.planes->hits, index))
+    {
+        return BSHIP_HIT;
+    }
+    else if (BoardMask_Test(&board.planes->misses, index))
+    {
+        return BSHIP_MISS;
+    }
+    else if (BoardMask_Test(&board.planes->ships, index))
+    {
+        return BSHIP_SHIP;
+    }
+    return BSHIP_WATER;
 }
 
+// NOTE(mattg): the board doesn't keep duplicates, they're stored as the value they duplicate.
 void BShip_Board_Set(BShip_Board board, uint8_t row, uint8_t column, BShip_BoardValue value)
 {
-    assert(board.buffer != NULL);
+    assert(board.planes != NULL);
     assert(board.size >= BSHIP_BOARD_SIZE_MIN);
     assert(board.size <= BSHIP_BOARD_SIZE_MAX);
     assert(row < board.size);
     assert(column < board.size);
-    uint32_t index = (row * board.size) + column;
-    board.buffer[index] = value;
+    uint32_t index = Board_Index(row, column);
+    BShip_BoardPlanes *planes = board.planes;
+    BoardMask_Clear(&planes->ships, index);
+    BoardMask_Clear(&planes->hits, index);
+    BoardMask_Clear(&planes->misses, index);
+    BoardMask_Clear(&planes->kills, index);
+    switch (value)
+    {
+    case BSHIP_WATER:
+        break;
+    case BSHIP_KILL:
+    case BSHIP_DUPLICATE_KILL:
+        BoardMask_Set(&planes->kills, index);
+        // fall through
+    case BSHIP_HIT:
+    case BSHIP_DUPLICATE_HIT:
+        BoardMask_Set(&planes->hits, index);
+        // fall through
+    case BSHIP_SHIP:
+        BoardMask_Set(&planes->ships, index);
+        break;
+    case BSHIP_MISS:
+    case BSHIP_DUPLICATE_MISS:
+        BoardMask_Set(&planes->misses, index);
+        break;
+    }
+}
+
+BShip_PackedShip BShip_Ship_Pack(BShip_Ship ship)
+{
+    // NOTE(mattg): a ship off the board doesn't fit, but then the whole ship is kept in the error anyway.
+    return (BShip_PackedShip)((ship.column & 0xF) | ((ship.row & 0xF) << 4) | ((ship.length & 0xF) << 8)
+        | ((ship.direction & 0xF) << 12));
+}
+
+BShip_Ship BShip_Ship_Unpack(BShip_PackedShip ship)
+{
+    return (BShip_Ship){
+        .row = BSHIP_PACKED_SHIP_ROW(ship),
+        .column = BSHIP_PACKED_SHIP_COLUMN(ship),
+        .length = BSHIP_PACKED_SHIP_LENGTH(ship),
+        .direction = BSHIP_PACKED_SHIP_DIRECTION(ship),
+    };
+}
+
+BShip_PackedShot BShip_Shot_Pack(BShip_Shot shot)
+{
+    return (BShip_PackedShot)((shot.column & 0xF) | ((shot.row & 0xF) << 4) | ((shot.value & 0x7) << 8));
+}
+
+BShip_Shot BShip_Shot_Unpack(BShip_PackedShot shot)
+{
+    return (BShip_Shot){
+        .row = BSHIP_PACKED_SHOT_ROW(shot),
+        .column = BSHIP_PACKED_SHOT_COLUMN(shot),
+        .value = BSHIP_PACKED_SHOT_VALUE(shot),
+    };
+}
+
+// Keeps the ships the game is played on, packed.
+void Game_StoreShips(BShip_GameState *game)
+{
+    BShip_ShipArray *ships[] = { &game->ai1_ships, &game->ai2_ships };
+    BShip_PackedShipArray *packed[] = { &game->data.ai1.ships, &game->data.ai2.ships };
+    for (size_t i = 0; i < (sizeof(ships) / sizeof(ships[0])); i++)
+    {
+        assert(ships[i]->length <= packed[i]->capacity);
+        for (packed[i]->length = 0; packed[i]->length < ships[i]->length; packed[i]->length++)
+        {
+            packed[i]->buffer[packed[i]->length] = BShip_Ship_Pack(ships[i]->buffer[packed[i]->length]);
+        }
+    }
+}
+
+// Keeps the shots of the given round, packed. Store them again once validating them filled in their values.
+void Game_StoreShots(BShip_GameState *game, uint32_t shot_index)
+{
+    assert(shot_index < game->data.ai1.shots.capacity);
+    assert(shot_index < game->data.ai2.shots.capacity);
+    game->data.ai1.shots.buffer[shot_index] = BShip_Shot_Pack(game->ai1_shot);
+    game->data.ai2.shots.buffer[shot_index] = BShip_Shot_Pack(game->ai2_shot);
+    game->data.ai1.shots.length = shot_index + 1;
+    game->data.ai2.shots.length = shot_index + 1;
+}
+
+static void AIGameData_CountShot(BShip_AIGameData *ai, BShip_BoardValue value)
+{
+    switch (value)
+    {
+    case BSHIP_HIT:
+    case BSHIP_KILL:
+        ai->hits++;
+        ai->num_board_shot++;
+        break;
+    case BSHIP_MISS:
+        ai->misses++;
+        ai->num_board_shot++;
+        break;
+    case BSHIP_DUPLICATE_HIT:
+    case BSHIP_DUPLICATE_MISS:
+    case BSHIP_DUPLICATE_KILL:
+        ai->duplicates++;
+        break;
+    case BSHIP_WATER:
+    case BSHIP_SHIP:
+        break;
+    }
 }
 
-void ShipLengths_Calculate(BShip_U8Array *array, uint8_t board_size)
+// Counts the shots of the round into the game's stats, once validating them filled in their values.
+void Game_CountShots(BShip_GameState *game)
+{
+    AIGameData_CountShot(&game->data.ai1, game->ai1_shot.value);
+    AIGameData_CountShot(&game->data.ai2, game->ai2_shot.value);
+}
+
+void ShipLengths_Calculate(BShip_U8Array *array, const BShip_BoardRules *rules)
 {
     assert(array != NULL);
     assert(array->buffer != NULL);
-    assert(board_size >= BSHIP_BOARD_SIZE_MIN);
-    assert(board_size <= BSHIP_BOARD_SIZE_MAX);
-    uint8_t ship_count_min = ShipCountMin_From_BoardSize(board_size);
-    uint8_t ship_count_max = ShipCountMax_From_BoardSize(board_size);
-    uint8_t ship_length_min = ShipLengthMin_From_BoardSize(board_size);
-    uint8_t ship_length_max = ShipLengthMax_From_BoardSize(board_size);
-
-    assert(array->capacity >= ship_count_max);
+    assert(rules != NULL);
+    assert(array->capacity >= rules->ship_count_max);
 
-    uint8_t ship_count = ship_count_max;
-    if (ship_count_max != ship_count_min)
+    uint8_t ship_count = rules->ship_count_max;
+    if (rules->ship_count_max != rules->ship_count_min)
     {
         // TODO: Randomly decide on the ship count.
     }
     for (array->length = 0; array->length < ship_count; array->length++)
     {
-        uint8_t ship_length = ship_length_max;
-        if (ship_length_max != ship_length_min)
+        uint8_t ship_length = rules->ship_length_max;
+        if (rules->ship_length_max != rules->ship_length_min)
         {
             // TODO: randomly decide the ship length.
         }
@@ -116,7 +383,7 @@ void BShip_U8Array_SwapBack(BShip_U8Array *array, uint8_t index)
 BShip_Error ValidateAndStoreShips(BShip_Board board, BShip_ShipArray *ships,
     BShip_U8Array *alive_ships, BShip_U8Array *ship_lengths)
 {
-    assert(board.buffer != NULL);
+    assert(board.planes != NULL);
     assert(board.size >= BSHIP_BOARD_SIZE_MIN);
     assert(board.size <= BSHIP_BOARD_SIZE_MAX);
     assert(ships != NULL);
@@ -126,6 +393,7 @@ BShip_Error ValidateAndStoreShips(BShip_Board board, BShip_ShipArray *ships,
     assert(ships->capacity == alive_ships->capacity);
     assert(ship_lengths != NULL);
     assert(ship_lengths->buffer != NULL);
+    assert(ships->length <= BSHIP_SHIP_COUNT_MAX);
     // NOTE(mattg): this check should have already been handled by the messages.
     assert(ships->length == ship_lengths->length);
     BShip_Error error = {
@@ -191,26 +459,25 @@ BShip_Error ValidateAndStoreShips(BShip_Board board, BShip_ShipArray *ships,
                 ship.direction == BSHIP_HORIZONTAL ? "HORIZONTAL" : "VERTICAL");
             return error;
         }
-        uint8_t row_multiplier = ship.direction == BSHIP_VERTICAL;
-        uint8_t column_multiplier = ship.direction == BSHIP_HORIZONTAL;
-        for (uint8_t i = 0; i < ship.length; i++)
+        BShip_BoardMask ship_mask = BoardMask_From_Ship(ship);
+        if (BoardMask_Intersects(&ship_mask, &board.planes->ships))
         {
-            uint8_t row = ship.row + (i * row_multiplier);
-            uint8_t column = ship.column + (i * column_multiplier);
-            if (BShip_Board_Get(board, row, column) != BSHIP_WATER)
-            {
-                error.type = ERROR_SHIP_OVERLAP;
-                error.ship = ship;
-                PRINT_ERROR("Ship returned overlaps with another ship already on the board");
-                fprintf(stderr, "\trow: %d\n\tcolumn: %d\n\tlength: %d\n\tdirection: %s\n",
-                    ship.row, ship.column, ship.length,
-                    ship.direction == BSHIP_HORIZONTAL ? "HORIZONTAL" : "VERTICAL");
-                return error;
-            }
-            else
-            {
-                BShip_Board_Set(board, row, column, BSHIP_SHIP);
-            }
+            error.type = ERROR_SHIP_OVERLAP;
+            error.ship = ship;
+            PRINT_ERROR("Ship returned overlaps with another ship already on the board");
+            fprintf(stderr, "\trow: %d\n\tcolumn: %d\n\tlength: %d\n\tdirection: %s\n",
+                ship.row, ship.column, ship.length,
+                ship.direction == BSHIP_HORIZONTAL ? "HORIZONTAL" : "VERTICAL");
+            return error;
+        }
+        BoardMask_Or(&board.planes->ships, &ship_mask);
+        board.planes->ship_masks[i] = ship_mask;
+        board.planes->hits_left[i] = ship.length;
+        for (uint8_t l = 0; l < ship.length; l++)
+        {
+            uint8_t row = ship.row + (ship.direction == BSHIP_VERTICAL ? l : 0);
+            uint8_t column = ship.column + (ship.direction == BSHIP_HORIZONTAL ? l : 0);
+            board.planes->ship_at[Board_Index(row, column)] = i;
         }
         alive_ships->buffer[alive_ships->length] = i;
         alive_ships->length++;
@@ -221,7 +488,7 @@ BShip_Error ValidateAndStoreShips(BShip_Board board, BShip_ShipArray *ships,
 
 BShip_Error ValidateAndStoreShot(BShip_Board opponent_board, BShip_Shot *shot)
 {
-    assert(opponent_board.buffer != NULL);
+    assert(opponent_board.planes != NULL);
     assert(opponent_board.size >= BSHIP_BOARD_SIZE_MIN);
     assert(opponent_board.size <= BSHIP_BOARD_SIZE_MAX);
     assert(shot != NULL);
@@ -239,90 +506,239 @@ BShip_Error ValidateAndStoreShot(BShip_Board opponent_board, BShip_Shot *shot)
         return error;
     }
 
-    BShip_BoardValue current_value = BShip_Board_Get(opponent_board, shot->row, shot->column);
-    switch (current_value)
+    BShip_BoardPlanes *planes = opponent_board.planes;
+    uint32_t index = Board_Index(shot->row, shot->column);
+    if (BoardMask_Test(&planes->kills, index))
+    {
+        shot->value = BSHIP_DUPLICATE_KILL;
+    }
+    else if (BoardMask_Test(&planes->hits, index))
     {
-    case BSHIP_WATER:
-        shot->value = BSHIP_MISS;
-        break;
-    case BSHIP_SHIP:
-        shot->value = BSHIP_HIT;
-        break;
-    case BSHIP_HIT:
-    case BSHIP_DUPLICATE_HIT:
         shot->value = BSHIP_DUPLICATE_HIT;
-        break;
-    case BSHIP_MISS:
-    case BSHIP_DUPLICATE_MISS:
+    }
+    else if (BoardMask_Test(&planes->misses, index))
+    {
         shot->value = BSHIP_DUPLICATE_MISS;
-        break;
-    case BSHIP_KILL:
-    case BSHIP_DUPLICATE_KILL:
-        shot->value = BSHIP_DUPLICATE_KILL;
-        break;
     }
-
-    BShip_Board_Set(opponent_board, shot->row, shot->column, shot->value);
+    else if (BoardMask_Test(&planes->ships, index))
+    {
+        shot->value = BSHIP_HIT;
+        BoardMask_Set(&planes->hits, index);
+        assert(planes->hits_left[planes->ship_at[index]] > 0);
+        planes->hits_left[planes->ship_at[index]]--;
+    }
+    else
+    {
+        shot->value = BSHIP_MISS;
+        BoardMask_Set(&planes->misses, index);
+    }
 
     // TODO(mattg): Check for duplicate and error only if that setting is present
     return error;
 }
 
-BShip_Ship *FindDeadShip(BShip_Board board, BShip_ShipArray ships,
+BShip_Ship *FindDeadShip(BShip_Board board, BShip_ShipArray ships, BShip_Shot shot,
     BShip_U8Array *alive_ships, BShip_U8Array *dead_ships)
 {
-    assert(board.buffer != NULL);
+    assert(board.planes != NULL);
     assert(ships.buffer != NULL);
     assert(alive_ships != NULL);
     assert(alive_ships->buffer != NULL);
     assert(dead_ships != NULL);
     assert(dead_ships->buffer != NULL);
 
+    // NOTE(mattg): Only a new hit can kill a ship, and only the ship it landed on. ValidateAndStoreShot
+    // already counted the hit down, so there is nothing to scan.
+    if (shot.value != BSHIP_HIT)
+    {
+        return NULL;
+    }
+    BShip_BoardPlanes *planes = board.planes;
+    uint8_t index = planes->ship_at[Board_Index(shot.row, shot.column)];
+    assert(index < ships.length);
+    if (planes->hits_left[index] != 0)
+    {
+        return NULL;
+    }
+
+    BoardMask_Or(&planes->kills, &planes->ship_masks[index]);
     for (uint8_t i = 0; i < alive_ships->length; i++)
     {
-        uint8_t index = alive_ships->buffer[i];
-        assert(index < ships.length);
-        BShip_Ship *ship = &ships.buffer[index];
+        if (alive_ships->buffer[i] == index)
+        {
+            BShip_U8Array_SwapBack(alive_ships, i);
+            break;
+        }
+    }
+    dead_ships->buffer[dead_ships->length] = index;
+    dead_ships->length++;
+
+    return &ships.buffer[index];
+}
+
+
+BShip_GameResult GameResult_Calculate(BShip_AIGameData *ai, BShip_AIGameData *opponent)
+{
+    assert(ai != NULL);
+    assert(opponent != NULL);
 
-        uint8_t hit_count = 0;
-        uint8_t row_multiplier = ship->direction == BSHIP_VERTICAL;
-        uint8_t column_multiplier = ship->direction == BSHIP_HORIZONTAL;
-        for (uint8_t j = 0; j < ship->length; j++)
+    bool ai_error = ai->error.type != ERROR_SUCCESS;
+    bool opponent_error = opponent->error.type != ERROR_SUCCESS;
+    if (ai_error || opponent_error)
+    {
+        if (ai_error && opponent_error)
         {
-            uint8_t row = ship->row + (j * row_multiplier);
-            uint8_t column = ship->column + (j * column_multiplier);
-            BShip_BoardValue value = BShip_Board_Get(board, row, column);
+            return BSHIP_TIE;
+        }
+        return ai_error ? BSHIP_LOSS : BSHIP_WIN;
+    }
 
-            if (value == BSHIP_SHIP)
-            {
-                break;
-            }
-            else if (value == BSHIP_HIT || value == BSHIP_DUPLICATE_HIT)
-            {
-                hit_count++;
-            }
-            else
-            {
-                // NOTE(mattg): If this condition is ever met, it means where a ship is supposed to be
-                // something else is, which is supposed to never happen.
-                assert(false);
-            }
+    // NOTE(mattg): both AIs shoot at the same time, so both fleets can die on the same shot.
+    bool ai_dead = ai->alive_ships.length == 0;
+    bool opponent_dead = opponent->alive_ships.length == 0;
+    if (ai_dead == opponent_dead)
+    {
+        return BSHIP_TIE;
+    }
+    return opponent_dead ? BSHIP_WIN : BSHIP_LOSS;
+}
+
+// Fills in what is only known once the game is over.
+void GameData_Finish(BShip_GameData *game)
+{
+    assert(game != NULL);
+    game->ai1.ships_killed = game->ai2.dead_ships.length;
+    game->ai2.ships_killed = game->ai1.dead_ships.length;
+    game->ai1.result = GameResult_Calculate(&game->ai1, &game->ai2);
+    game->ai2.result = GameResult_Calculate(&game->ai2, &game->ai1);
+}
+
+static BShip_Ship Ship_From_Player(BShip_PlayerShip ship)
+{
+    return (BShip_Ship){
+        .row = ship.row,
+        .column = ship.column,
+        .length = ship.length,
+        .direction = (BShip_Direction)ship.direction,
+    };
+}
+
+static BShip_PlayerShip Player_From_Ship(BShip_Ship ship)
+{
+    return (BShip_PlayerShip){
+        .row = ship.row,
+        .column = ship.column,
+        .length = ship.length,
+        .direction = (uint8_t)ship.direction,
+    };
+}
+
+static BShip_PlayerShot Player_From_Shot(BShip_Shot shot)
+{
+    return (BShip_PlayerShot){
+        .row = shot.row,
+        .column = shot.column,
+        .value = (uint8_t)shot.value,
+    };
+}
+
+// Takes the shots and ships by seat, player 1's first.
+static void Player_TellShotResult(BShip_Player *player, BShip_Shot player1_shot, BShip_Shot player2_shot,
+    BShip_Ship *player1_dead_ship, BShip_Ship *player2_dead_ship)
+{
+    player->handle_shot_result(player->data, BSHIP_PLAYER_1, Player_From_Shot(player1_shot));
+    player->handle_shot_result(player->data, BSHIP_PLAYER_2, Player_From_Shot(player2_shot));
+    if (player1_dead_ship != NULL)
+    {
+        player->handle_ship_dead(player->data, BSHIP_PLAYER_1, Player_From_Ship(*player1_dead_ship));
+    }
+    if (player2_dead_ship != NULL)
+    {
+        player->handle_ship_dead(player->data, BSHIP_PLAYER_2, Player_From_Ship(*player2_dead_ship));
+    }
+}
+
+// Plays one game between two in-process players, leaving the result (or error) in the game data. The game has to
+// be freshly set up, with both boards empty and the ship lengths calculated.
+void Game_Simulate(BShip_GameState *game, BShip_Player *player1, BShip_Player *player2)
+{
+    assert(game != NULL);
+    assert(player1 != NULL);
+    assert(player2 != NULL);
+    BShip_AIGameData *ai1 = &game->data.ai1;
+    BShip_AIGameData *ai2 = &game->data.ai2;
+    uint8_t ship_count = (uint8_t)game->ship_lengths.length;
+    assert(ship_count <= BSHIP_SHIP_COUNT_MAX);
+
+    BShip_Player *first = game->seats_swapped ? player2 : player1;
+    BShip_Player *second = game->seats_swapped ? player1 : player2;
+    first->start_game(first->data);
+    second->start_game(second->data);
+
+    // NOTE(mattg): both get the lengths before validating, which swaps them around.
+    BShip_PlayerShip ai1_ships[BSHIP_SHIP_COUNT_MAX] = {0}, ai2_ships[BSHIP_SHIP_COUNT_MAX] = {0};
+    first->choose_ship_placements(first->data, game->ship_lengths.buffer, ship_count,
+        game->seats_swapped ? ai2_ships : ai1_ships);
+    second->choose_ship_placements(second->data, game->ship_lengths.buffer, ship_count,
+        game->seats_swapped ? ai1_ships : ai2_ships);
+    for (uint8_t i = 0; i < ship_count; i++)
+    {
+        game->ai1_ships.buffer[i] = Ship_From_Player(ai1_ships[i]);
+        game->ai2_ships.buffer[i] = Ship_From_Player(ai2_ships[i]);
+    }
+    game->ai1_ships.length = ship_count;
+    game->ai2_ships.length = ship_count;
+    Game_StoreShips(game);
+
+    ai1->error = ValidateAndStoreShips(game->ai1_board, &game->ai1_ships, &ai1->alive_ships, &game->ship_lengths);
+    ai2->error = ValidateAndStoreShips(game->ai2_board, &game->ai2_ships, &ai2->alive_ships,
+        &game->ship_lengths_copy);
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; game->next_shot; i++)
+    {
+        assert(i < game->shot_count_max);
+        BShip_PlayerShot shots[2];
+        shots[0] = first->choose_shot(first->data);
+        shots[1] = second->choose_shot(second->data);
+        BShip_PlayerShot ai1_shot = shots[game->seats_swapped ? 1 : 0];
+        BShip_PlayerShot ai2_shot = shots[game->seats_swapped ? 0 : 1];
+        game->ai1_shot = (BShip_Shot){ .row = ai1_shot.row, .column = ai1_shot.column };
+        game->ai2_shot = (BShip_Shot){ .row = ai2_shot.row, .column = ai2_shot.column };
+
+        ai1->error = ValidateAndStoreShot(game->ai2_board, &game->ai1_shot);
+        ai2->error = ValidateAndStoreShot(game->ai1_board, &game->ai2_shot);
+        Game_StoreShots(game, i);
+        if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+        {
+            return;
         }
-        if (hit_count == ship->length)
+        Game_CountShots(game);
+
+        BShip_Ship *ai1_dead_ship = FindDeadShip(game->ai1_board, game->ai1_ships, game->ai2_shot,
+            &ai1->alive_ships, &ai1->dead_ships);
+        BShip_Ship *ai2_dead_ship = FindDeadShip(game->ai2_board, game->ai2_ships, game->ai1_shot,
+            &ai2->alive_ships, &ai2->dead_ships);
+        if (i == (game->shot_count_max - 1) || ai1->alive_ships.length == 0 || ai2->alive_ships.length == 0)
         {
-            for(uint8_t j = 0; j < ship->length; j++)
-            {
-                uint8_t row = ship->row + (j * row_multiplier);
-                uint8_t column = ship->column + (j * column_multiplier);
-                BShip_Board_Set(board, row, column, BSHIP_KILL);
-            }
-            BShip_U8Array_SwapBack(alive_ships, i);
-            dead_ships->buffer[dead_ships->length] = index;
-            dead_ships->length++;
+            game->next_shot = false;
+        }
 
-            return ship;
+        if (game->seats_swapped)
+        {
+            Player_TellShotResult(first, game->ai2_shot, game->ai1_shot, ai2_dead_ship, ai1_dead_ship);
+            Player_TellShotResult(second, game->ai2_shot, game->ai1_shot, ai2_dead_ship, ai1_dead_ship);
+        }
+        else
+        {
+            Player_TellShotResult(first, game->ai1_shot, game->ai2_shot, ai1_dead_ship, ai2_dead_ship);
+            Player_TellShotResult(second, game->ai1_shot, game->ai2_shot, ai1_dead_ship, ai2_dead_ship);
         }
     }
-    return NULL;
-}
 
+    first->handle_game_over(first->data);
+    second->handle_game_over(second->data);
+}
@@ -0,0 +1,1390 @@
+/**
+ * @file match.c
+ * @author Matthew Getgen
+ * @brief Resumable state machine for games and matches.
+ * @date 2026-06-02
+ *
+ * A match never blocks in here. It only says what it needs next (send the messages it created, or receive a
+ * message from both AIs), and is moved forward by the driver calling Match_OnSendComplete or
+ * Match_OnMessageReceived once that is done. All of the state lives in the match's arena, so a driver can keep
+ * as many matches going at once as it has arenas for.
+ *
+ * When both AIs are plugins (see battleshipsplayer.h) there is nothing to wait on, so the first Match_Advance plays
+ * the whole match with direct calls into the players, using the same validation and kill logic.
+ */
+
+#include "battleshipslib.h"
+
+typedef enum {
+    MATCH_STEP_SEND,
+    MATCH_STEP_RECEIVE,
+    MATCH_STEP_EXIT, // NOTE(mattg): the games are over, waiting on the AIs that aren't kept to exit.
+    MATCH_STEP_DONE,
+} BShip_MatchStep;
+
+typedef enum {
+    MATCH_PHASE_HELLO,
+    MATCH_PHASE_SETUP,
+    MATCH_PHASE_SWAPPING_SEATS, // NOTE(mattg): setup match again between the games of a pair, nothing comes back.
+    MATCH_PHASE_PLACING_SHIPS,
+    MATCH_PHASE_TAKING_SHOTS,
+    MATCH_PHASE_MATCH_OVER,
+} BShip_MatchPhase;
+
+typedef struct {
+    BShip_MatchData data;
+    BShip_GameState game;
+    BShip_GameSink sink;
+    uint8_t pair_ship_lengths[BSHIP_SHIP_COUNT_MAX];
+    BShip_GameResult pair_first_result; // NOTE(mattg): ai1's result in the first game of the pair being played.
+    const BShip_BoardRules *rules;
+    BShip_Arena *arena;
+    BShip_Connection *conn;
+    BShip_AIConnection *ai1_conn;
+    BShip_AIConnection *ai2_conn;
+    BShip_Message ai1_message;
+    BShip_Message ai2_message;
+    BShip_ErrorType ai1_receive_error;
+    BShip_ErrorType ai2_receive_error;
+    double start_time;
+    BShip_MatchPhase phase;
+    BShip_MatchStep step;
+    bool ai1_pending;
+    bool ai2_pending;
+    bool ai1_framed;
+    bool ai2_framed;
+    BShip_MessageEncoding ai1_encoding;
+    BShip_MessageEncoding ai2_encoding;
+    // NOTE(mattg): the player number each AI was last set up with. Only the ones that support new matches can be set up
+    // again mid-match, the others keep their seat for the whole match.
+    BShip_PlayerNum ai1_seat;
+    BShip_PlayerNum ai2_seat;
+    // NOTE(mattg): the AIs come from the pool when there is one (and it has room), otherwise from the match's own.
+    BShip_AIPool *pool;
+    BShip_AIPoolEntry *ai1_entry;
+    BShip_AIPoolEntry *ai2_entry;
+    BShip_AIPoolEntry ai1_own_entry;
+    BShip_AIPoolEntry ai2_own_entry;
+    bool ai1_kept;
+    bool ai2_kept;
+    bool ai1_exiting;
+    bool ai2_exiting;
+    bool ai1_exit_timed_out;
+    bool ai2_exit_timed_out;
+    bool exit_begun;
+    bool registered;
+    bool debug;
+    // NOTE(mattg): only used when both AIs are plugins.
+    BShip_Library *ai1_library;
+    BShip_Library *ai2_library;
+    BShip_Player ai1_player;
+    BShip_Player ai2_player;
+    bool ai1_player_created;
+    bool ai2_player_created;
+    bool in_process;
+} BShip_MatchState;
+
+static void Game_Begin(BShip_MatchState *state);
+
+static bool Match_AllocateGames(BShip_MatchState *state)
+{
+    BShip_MatchData *match = &state->data;
+    if (state->sink.proc != NULL)
+    {
+        return true;
+    }
+    match->games.buffer = BSHIP_ARENA_PUSH_ARRAY(state->arena, BShip_GameData, match->games_per_match);
+    match->games.capacity = match->games_per_match;
+    match->games.length = 0;
+    if (match->games.buffer == NULL)
+    {
+        match->games.capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+// Only an AI that got through the whole match without a mistake is kept for another one, anything else (like a late
+// reply after a timeout) could still be on its way.
+static bool Match_CanKeepAI(BShip_AIPoolEntry *entry, BShip_AIMatchData *ai, BShip_AIGameData *game)
+{
+    return entry != NULL && entry->pool != NULL && entry->new_match && !entry->zygote &&
+        ai->error.type == ERROR_SUCCESS && game->error.type == ERROR_SUCCESS;
+}
+
+static void Match_Over(BShip_MatchState *state)
+{
+    state->ai1_kept = Match_CanKeepAI(state->ai1_entry, &state->data.ai1, &state->game.data.ai1);
+    state->ai2_kept = Match_CanKeepAI(state->ai2_entry, &state->data.ai2, &state->game.data.ai2);
+    // NOTE(mattg): read before they're told the match is over, since an AI forked by a zygote exits (and gets reaped
+    // by the zygote, taking its /proc entry with it) as soon as it reads that. The ones we wait on get this replaced
+    // with what wait4() says in Match_ReleaseAI.
+    BShip_AIConnection_SampleUsage(state->ai1_conn, &state->data.ai1.usage);
+    BShip_AIConnection_SampleUsage(state->ai2_conn, &state->data.ai2.usage);
+    BShip_Message_MatchOver_Create(&state->ai1_message, state->ai1_kept);
+    BShip_Message_MatchOver_Create(&state->ai2_message, state->ai2_kept);
+    state->phase = MATCH_PHASE_MATCH_OVER;
+    state->step = MATCH_STEP_SEND;
+}
+
+static bool Match_HasGamesLeft(BShip_MatchData *match, const BShip_GameSink *sink)
+{
+    if (sink->proc != NULL)
+    {
+        return match->games_played < match->games_per_match;
+    }
+    return match->games.length < match->games.capacity;
+}
+
+static void AIMatchData_AddGame(BShip_AIMatchData *ai, BShip_AIGameData *game, bool finished)
+{
+    switch (game->result)
+    {
+    case BSHIP_WIN:
+        ai->wins++;
+        break;
+    case BSHIP_LOSS:
+        ai->losses++;
+        break;
+    case BSHIP_TIE:
+        ai->ties++;
+        break;
+    }
+    ai->total_num_board_shot += game->num_board_shot;
+    ai->total_hits += game->hits;
+    ai->total_misses += game->misses;
+    ai->total_duplicates += game->duplicates;
+    ai->total_ships_killed += game->ships_killed;
+
+    if (game->result != BSHIP_WIN || !finished)
+    {
+        return;
+    }
+    uint32_t shots = game->shots.length;
+    assert(shots <= BSHIP_SHOT_LENGTH_MAX);
+    ai->shots_to_win[shots]++;
+    // NOTE(mattg): Welford's running mean and variance, the sum of squares is recovered from the variance.
+    double count = (double)ai->shots_to_win_count;
+    double sum_squares = ai->shots_to_win_variance * count;
+    double delta = (double)shots - ai->shots_to_win_mean;
+    ai->shots_to_win_count++;
+    ai->shots_to_win_mean += delta / (count + 1.0);
+    sum_squares += delta * ((double)shots - ai->shots_to_win_mean);
+    ai->shots_to_win_variance = sum_squares / (count + 1.0);
+}
+
+// NOTE(mattg): a paired match is scored by its pairs, everything else by its games.
+static void Match_GetWins(BShip_MatchData *match, double *ai1_wins, double *ai2_wins)
+{
+    *ai1_wins = match->paired ? match->ai1.pair_wins : match->ai1.wins;
+    *ai2_wins = match->paired ? match->ai2.pair_wins : match->ai2.wins;
+}
+
+// Wald's log likelihood ratio between "this AI wins BSHIP_MATCH_STOP_MARGIN more than half of the games (or pairs)
+// that aren't ties" and "it wins half of them".
+static double Match_LogLikelihoodRatio(double wins, double losses)
+{
+    return wins * log(1.0 + 2.0 * BSHIP_MATCH_STOP_MARGIN) + losses * log(1.0 - 2.0 * BSHIP_MATCH_STOP_MARGIN);
+}
+
+// NOTE(mattg): the normal approximation with a flat prior, for the share of the decided games ai1 wins over ai2.
+// How likely the leader really wins more than half of them.
+static double Match_GetLeadConfidence(double lead, double decided)
+{
+    return 0.5 * erfc(-lead / sqrt(2.0 * decided));
+}
+
+// How likely neither AI wins BSHIP_MATCH_STOP_MARGIN more than half of them.
+static double Match_GetEvenConfidence(double lead, double decided)
+{
+    double margin = 2.0 * BSHIP_MATCH_STOP_MARGIN * decided;
+    double scale = sqrt(2.0 * decided);
+    return 0.5 * erfc(-(margin - lead) / scale) - 0.5 * erfc((margin + lead) / scale);
+}
+
+static int32_t GameResult_GetScore(BShip_GameResult result)
+{
+    return result == BSHIP_WIN ? 1 : (result == BSHIP_LOSS ? -1 : 0);
+}
+
+// Scores the pair once its second game is over, the first game's result is kept in pair_first_result until then.
+// A match that ends in the middle of a pair leaves it unscored.
+static void MatchData_AddPairGame(BShip_MatchData *match, BShip_GameData *game, BShip_GameResult *pair_first_result)
+{
+    if (match->games_played % 2 == 0)
+    {
+        *pair_first_result = game->ai1.result;
+        return;
+    }
+    int32_t score = GameResult_GetScore(*pair_first_result) + GameResult_GetScore(game->ai1.result);
+    if (score > 0)
+    {
+        match->ai1.pair_wins++;
+        match->ai2.pair_losses++;
+    }
+    else if (score < 0)
+    {
+        match->ai1.pair_losses++;
+        match->ai2.pair_wins++;
+    }
+    else
+    {
+        match->ai1.pair_ties++;
+        match->ai2.pair_ties++;
+    }
+}
+
+// Folds the finished game into the match totals, so they never need the games themselves.
+static void MatchData_AddGame(BShip_MatchData *match, BShip_GameData *game, BShip_GameResult *pair_first_result)
+{
+    GameData_Finish(game);
+    bool finished = game->ai1.error.type == ERROR_SUCCESS && game->ai2.error.type == ERROR_SUCCESS;
+    AIMatchData_AddGame(&match->ai1, &game->ai1, finished);
+    AIMatchData_AddGame(&match->ai2, &game->ai2, finished);
+    if (match->paired)
+    {
+        MatchData_AddPairGame(match, game, pair_first_result);
+    }
+    double ai1_wins, ai2_wins;
+    Match_GetWins(match, &ai1_wins, &ai2_wins);
+    if (ai1_wins + ai2_wins > 0.0)
+    {
+        match->confidence = (float)Match_GetLeadConfidence(fabs(ai1_wins - ai2_wins), ai1_wins + ai2_wins);
+    }
+}
+
+// Sobel and Wald's three way test, made of a ratio test for each AI being better. The match is decided once one of
+// them finds its AI better, or both find that neither is, so even AIs end up even instead of going on forever.
+// Even AIs get a winner, and a better AI is called even, at most 1 - the stop confidence of the time.
+// NOTE(mattg): the ratio tests only decide when to stop, the match still has to reach the stop confidence (for the
+// leader, or for being even) so that it is never stopped less sure than asked.
+static bool Match_IsDecided(BShip_MatchData *match)
+{
+    if (match->stop_confidence <= 0.0f || (match->paired && match->games_played % 2 != 0))
+    {
+        return false;
+    }
+    double ai1_wins, ai2_wins;
+    Match_GetWins(match, &ai1_wins, &ai2_wins);
+    double ai1_ratio = Match_LogLikelihoodRatio(ai1_wins, ai2_wins);
+    double ai2_ratio = Match_LogLikelihoodRatio(ai2_wins, ai1_wins);
+    // NOTE(mattg): either test can call a winner, so each gets half of the error rate for that.
+    double error = 1.0 - match->stop_confidence;
+    double better_bound = log((1.0 - error) / (0.5 * error));
+    double even_bound = log(error / (1.0 - 0.5 * error));
+    if (ai1_ratio >= better_bound || ai2_ratio >= better_bound)
+    {
+        return match->confidence >= match->stop_confidence;
+    }
+    else if (ai1_ratio <= even_bound && ai2_ratio <= even_bound)
+    {
+        float confidence = (float)Match_GetEvenConfidence(fabs(ai1_wins - ai2_wins), ai1_wins + ai2_wins);
+        if (confidence >= match->stop_confidence)
+        {
+            match->confidence = confidence;
+            match->even = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Hands the finished game to the sink, or keeps it with the match. Returns false once the match is over.
+static bool Match_StoreGame(BShip_MatchData *match, const BShip_GameSink *sink, BShip_Arena *arena,
+    BShip_GameState *game, BShip_GameResult *pair_first_result)
+{
+    MatchData_AddGame(match, &game->data, pair_first_result);
+    if (sink->proc != NULL)
+    {
+        sink->proc(sink->data, match->games_played, &game->data);
+        BShip_Arena_Rollback(arena, game->data_mark);
+    }
+    else
+    {
+        BShip_Arena_Rollback(arena, game->mark);
+        assert(match->games.length < match->games.capacity);
+        match->games.buffer[match->games.length] = game->data;
+        match->games.length++;
+    }
+    match->games_played++;
+
+    if (game->data.ai1.error.type != ERROR_SUCCESS || game->data.ai2.error.type != ERROR_SUCCESS)
+    {
+        return false;
+    }
+    if (!Match_HasGamesLeft(match, sink))
+    {
+        return false;
+    }
+    if (Match_IsDecided(match))
+    {
+        match->stopped_early = true;
+        return false;
+    }
+    return true;
+}
+
+static BShip_PlayerNum PlayerNum_Other(BShip_PlayerNum player)
+{
+    return player == BSHIP_PLAYER_1 ? BSHIP_PLAYER_2 : BSHIP_PLAYER_1;
+}
+
+// Sets up the AIs that support new matches again with the other seat, before each game of a paired match after the
+// first. The rest of the match is already framed, so this setup match is too.
+static void Match_SwapSeats(BShip_MatchState *state)
+{
+    bool ai1_swaps = state->ai1_entry != NULL && state->ai1_entry->new_match;
+    bool ai2_swaps = state->ai2_entry != NULL && state->ai2_entry->new_match;
+    if (!ai1_swaps && !ai2_swaps)
+    {
+        Game_Begin(state);
+        return;
+    }
+    // NOTE(mattg): an empty message isn't sent, for the AI that keeps its seat.
+    state->ai1_message.length = 0;
+    state->ai2_message.length = 0;
+    if (ai1_swaps)
+    {
+        state->ai1_seat = PlayerNum_Other(state->ai1_seat);
+        BShip_Message_SetupMatch_Create(&state->ai1_message, state->data.board_size, state->ai1_seat,
+            state->ai1_framed, state->ai1_encoding);
+    }
+    if (ai2_swaps)
+    {
+        state->ai2_seat = PlayerNum_Other(state->ai2_seat);
+        BShip_Message_SetupMatch_Create(&state->ai2_message, state->data.board_size, state->ai2_seat,
+            state->ai2_framed, state->ai2_encoding);
+    }
+    state->phase = MATCH_PHASE_SWAPPING_SEATS;
+    state->step = MATCH_STEP_SEND;
+}
+
+static void Game_End(BShip_MatchState *state)
+{
+    if (!Match_StoreGame(&state->data, &state->sink, state->arena, &state->game, &state->pair_first_result))
+    {
+        Match_Over(state);
+        return;
+    }
+    if (state->data.paired)
+    {
+        Match_SwapSeats(state);
+        return;
+    }
+    Game_Begin(state);
+}
+
+// Sets up the memory and boards for the next game, returns false when out of memory.
+static bool Game_Allocate(BShip_GameState *game, BShip_Arena *arena, const BShip_BoardRules *rules)
+{
+    uint8_t board_size = rules->board_size;
+    uint8_t ship_count_max = rules->ship_count_max;
+
+    memset(game, 0, sizeof(BShip_GameState));
+    game->shot_count_max = rules->shot_count_max;
+    game->next_shot = true;
+
+    // NOTE(mattg): the ships and shots are kept with the match, everything after the mark is only for this game.
+    game->data_mark = BShip_ArenaMark_Get(arena);
+    BShip_AIGameData *ais[] = { &game->data.ai1, &game->data.ai2 };
+    for (size_t i = 0; i < (sizeof(ais) / sizeof(ais[0])); i++)
+    {
+        BShip_AIGameData *ai = ais[i];
+        ai->ships.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_PackedShip, ship_count_max);
+        ai->ships.capacity = ship_count_max;
+        ai->alive_ships.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max);
+        ai->alive_ships.capacity = ship_count_max;
+        ai->dead_ships.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max);
+        ai->dead_ships.capacity = ship_count_max;
+        ai->shots.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_PackedShot, game->shot_count_max);
+        ai->shots.capacity = game->shot_count_max;
+    }
+    game->mark = BShip_ArenaMark_Get(arena);
+    if (game->data.ai1.ships.buffer == NULL || game->data.ai2.ships.buffer == NULL ||
+        game->data.ai1.alive_ships.buffer == NULL || game->data.ai2.alive_ships.buffer == NULL ||
+        game->data.ai1.dead_ships.buffer == NULL || game->data.ai2.dead_ships.buffer == NULL ||
+        game->data.ai1.shots.buffer == NULL || game->data.ai2.shots.buffer == NULL)
+    {
+        // NOTE(mattg): out of memory, end the match without storing a game that never happened.
+        BShip_Arena_Rollback(arena, game->mark);
+        return false;
+    }
+
+    game->ai1_board = BShip_Board_Allocate(arena, board_size);
+    game->ai2_board = BShip_Board_Allocate(arena, board_size);
+    game->ai1_ships = (BShip_ShipArray){
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_Ship, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    game->ai2_ships = (BShip_ShipArray){
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_Ship, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    game->ship_lengths = (BShip_U8Array){
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    // NOTE(mattg): we need a copy of this to use when comparing ship lengths for both AIs.
+    game->ship_lengths_copy = (BShip_U8Array){
+        .buffer = BSHIP_ARENA_PUSH_ARRAY(arena, uint8_t, ship_count_max),
+        .capacity = ship_count_max,
+    };
+    if (game->ai1_board.planes == NULL || game->ai2_board.planes == NULL ||
+        game->ai1_ships.buffer == NULL || game->ai2_ships.buffer == NULL ||
+        game->ship_lengths.buffer == NULL || game->ship_lengths_copy.buffer == NULL)
+    {
+        BShip_Arena_Rollback(arena, game->mark);
+        return false;
+    }
+    ShipLengths_Calculate(&game->ship_lengths, rules);
+    memcpy(game->ship_lengths_copy.buffer, game->ship_lengths.buffer, ship_count_max * sizeof(uint8_t));
+    game->ship_lengths_copy.length = game->ship_lengths.length;
+    return true;
+}
+
+// Sets up the next game of the match. The second game of a pair swaps the seats and plays the same ship lengths as
+// the first, which are kept in pair_ship_lengths.
+static bool Match_AllocateGame(BShip_MatchData *match, BShip_GameState *game, BShip_Arena *arena,
+    const BShip_BoardRules *rules, uint8_t *pair_ship_lengths)
+{
+    if (!Game_Allocate(game, arena, rules))
+    {
+        return false;
+    }
+    if (!match->paired)
+    {
+        return true;
+    }
+    uint32_t ship_count = game->ship_lengths.length;
+    if (match->games_played % 2 == 0)
+    {
+        memcpy(pair_ship_lengths, game->ship_lengths.buffer, ship_count * sizeof(uint8_t));
+        return true;
+    }
+    memcpy(game->ship_lengths.buffer, pair_ship_lengths, ship_count * sizeof(uint8_t));
+    memcpy(game->ship_lengths_copy.buffer, pair_ship_lengths, ship_count * sizeof(uint8_t));
+    game->seats_swapped = true;
+    return true;
+}
+
+static void Game_Begin(BShip_MatchState *state)
+{
+    BShip_GameState *game = &state->game;
+    if (!Match_AllocateGame(&state->data, game, state->arena, state->rules, state->pair_ship_lengths))
+    {
+        Match_Over(state);
+        return;
+    }
+    state->phase = MATCH_PHASE_PLACING_SHIPS;
+
+    BShip_Message_PlaceShips_Create(&state->ai1_message, game->ship_lengths.buffer, game->ship_lengths.length);
+    memcpy(state->ai2_message.buffer, state->ai1_message.buffer, BSHIP_MESSAGE_SIZE);
+    state->ai2_message.length = state->ai1_message.length;
+    state->step = MATCH_STEP_SEND;
+}
+
+static void Game_OnShipsPlaced(BShip_MatchState *state)
+{
+    BShip_GameState *game = &state->game;
+    BShip_AIGameData *ai1 = &game->data.ai1;
+    BShip_AIGameData *ai2 = &game->data.ai2;
+
+    ai1->error.type = state->ai1_receive_error;
+    ai2->error.type = state->ai2_receive_error;
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+
+    uint8_t ship_count = (uint8_t)game->ship_lengths.length;
+    ai1->error.type = BShip_Message_ShipsPlaced_Parse(state->arena, state->ai1_message, &game->ai1_ships,
+        ship_count, state->ai1_encoding);
+    ai2->error.type = BShip_Message_ShipsPlaced_Parse(state->arena, state->ai2_message, &game->ai2_ships,
+        ship_count, state->ai2_encoding);
+    Game_StoreShips(game);
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+
+    ai1->error = ValidateAndStoreShips(game->ai1_board, &game->ai1_ships, &ai1->alive_ships, &game->ship_lengths);
+    ai2->error = ValidateAndStoreShips(game->ai2_board, &game->ai2_ships, &ai2->alive_ships,
+        &game->ship_lengths_copy);
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+
+    // NOTE(mattg): the AIs take their first shot right after placing their ships, without being asked.
+    state->phase = MATCH_PHASE_TAKING_SHOTS;
+    state->step = MATCH_STEP_RECEIVE;
+}
+
+// Shot results list player 1's shot and ship first, so an AI sitting in the other seat gets them the other way around.
+static void Game_CreateShotResult(BShip_GameState *game, BShip_Message *message, bool ai1_first,
+    BShip_Ship *ai1_dead_ship, BShip_Ship *ai2_dead_ship, BShip_MessageEncoding encoding)
+{
+    if (ai1_first)
+    {
+        BShip_Message_ShotResult_Create(message, game->ai1_shot, game->ai2_shot, ai1_dead_ship, ai2_dead_ship,
+            game->next_shot, encoding);
+    }
+    else
+    {
+        BShip_Message_ShotResult_Create(message, game->ai2_shot, game->ai1_shot, ai2_dead_ship, ai1_dead_ship,
+            game->next_shot, encoding);
+    }
+}
+
+static void Game_OnShotsReceived(BShip_MatchState *state)
+{
+    BShip_GameState *game = &state->game;
+    BShip_AIGameData *ai1 = &game->data.ai1;
+    BShip_AIGameData *ai2 = &game->data.ai2;
+    uint32_t i = game->shot_index;
+    assert(i < game->shot_count_max);
+
+    if (i == (game->shot_count_max - 1))
+    {
+        game->next_shot = false;
+    }
+
+    ai1->error.type = state->ai1_receive_error;
+    ai2->error.type = state->ai2_receive_error;
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+
+    game->ai1_shot = (BShip_Shot){0};
+    game->ai2_shot = (BShip_Shot){0};
+    ai1->error.type = BShip_Message_ShotTaken_Parse(state->arena, state->ai1_message, &game->ai1_shot,
+        state->ai1_encoding);
+    ai2->error.type = BShip_Message_ShotTaken_Parse(state->arena, state->ai2_message, &game->ai2_shot,
+        state->ai2_encoding);
+    Game_StoreShots(game, i);
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+
+    ai1->error = ValidateAndStoreShot(game->ai2_board, &game->ai1_shot);
+    ai2->error = ValidateAndStoreShot(game->ai1_board, &game->ai2_shot);
+    Game_StoreShots(game, i);
+    if (ai1->error.type != ERROR_SUCCESS || ai2->error.type != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+    Game_CountShots(game);
+
+    BShip_Ship *ai1_dead_ship = FindDeadShip(game->ai1_board, game->ai1_ships, game->ai2_shot,
+        &ai1->alive_ships, &ai1->dead_ships);
+    BShip_Ship *ai2_dead_ship = FindDeadShip(game->ai2_board, game->ai2_ships, game->ai1_shot,
+        &ai2->alive_ships, &ai2->dead_ships);
+    if (ai1->alive_ships.length == 0 || ai2->alive_ships.length == 0)
+    {
+        game->next_shot = false;
+    }
+
+    // NOTE(mattg): both AIs get the same result, but they might not have asked for the same encoding, or agree on who
+    // is player 1 (when only one of them swapped seats).
+    bool ai1_sees_ai1_first = state->ai1_seat == BSHIP_PLAYER_1;
+    bool ai2_sees_ai1_first = state->ai2_seat == BSHIP_PLAYER_2;
+    Game_CreateShotResult(game, &state->ai1_message, ai1_sees_ai1_first, ai1_dead_ship, ai2_dead_ship,
+        state->ai1_encoding);
+    if (state->ai1_encoding == state->ai2_encoding && ai1_sees_ai1_first == ai2_sees_ai1_first)
+    {
+        memcpy(state->ai2_message.buffer, state->ai1_message.buffer, BSHIP_MESSAGE_SIZE);
+        state->ai2_message.length = state->ai1_message.length;
+    }
+    else
+    {
+        Game_CreateShotResult(game, &state->ai2_message, ai2_sees_ai1_first, ai1_dead_ship, ai2_dead_ship,
+            state->ai2_encoding);
+    }
+    game->shot_index++;
+    state->step = MATCH_STEP_SEND;
+}
+
+static void Game_OnSendComplete(BShip_MatchState *state, BShip_ErrorType ai1_error, BShip_ErrorType ai2_error)
+{
+    BShip_GameState *game = &state->game;
+    game->data.ai1.error.type = ai1_error;
+    game->data.ai2.error.type = ai2_error;
+    if (ai1_error != ERROR_SUCCESS || ai2_error != ERROR_SUCCESS)
+    {
+        Game_End(state);
+        return;
+    }
+    if (state->phase == MATCH_PHASE_TAKING_SHOTS && !game->next_shot)
+    {
+        Game_End(state);
+        return;
+    }
+    state->step = MATCH_STEP_RECEIVE;
+}
+
+static BShip_ErrorType MatchAI_OnHello(BShip_Arena *arena, BShip_Message message, BShip_AIPoolEntry *entry,
+    BShip_AIMatchData *ai, bool *framed, BShip_MessageEncoding *encoding, bool debug)
+{
+    bool zygote = false;
+    BShip_ErrorType error = BShip_Message_Hello_Parse(arena, message, ai->name, ai->authors, framed, encoding,
+        &entry->new_match, &zygote);
+    if (error != ERROR_SUCCESS)
+    {
+        memcpy(ai->error.message.buffer, message.buffer, BSHIP_MESSAGE_SIZE);
+        return error;
+    }
+    entry->zygote = zygote && entry->pool != NULL && AIPool_AddZygote(entry->pool, entry->path, entry->dir, debug);
+    // NOTE(mattg): kept for the matches that reuse this AI.
+    memcpy(entry->name, ai->name, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    memcpy(entry->authors, ai->authors, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    entry->framed = *framed;
+    entry->encoding = *encoding;
+    return ERROR_SUCCESS;
+}
+
+static void Match_Setup(BShip_MatchState *state);
+
+static void Match_OnHelloReceived(BShip_MatchState *state)
+{
+    BShip_MatchData *match = &state->data;
+    match->ai1.error.type = state->ai1_receive_error;
+    match->ai2.error.type = state->ai2_receive_error;
+    if (match->ai1.error.type != ERROR_SUCCESS || match->ai2.error.type != ERROR_SUCCESS)
+    {
+        state->step = MATCH_STEP_DONE;
+        return;
+    }
+
+    // NOTE(mattg): an AI reused from the pool said hello in the match it was started for, it isn't sent again.
+    if (!match->ai1.reused)
+    {
+        match->ai1.error.type = MatchAI_OnHello(state->arena, state->ai1_message, state->ai1_entry, &match->ai1,
+            &state->ai1_framed, &state->ai1_encoding, state->debug);
+    }
+    if (!match->ai2.reused)
+    {
+        match->ai2.error.type = MatchAI_OnHello(state->arena, state->ai2_message, state->ai2_entry, &match->ai2,
+            &state->ai2_framed, &state->ai2_encoding, state->debug);
+    }
+    if (match->ai1.error.type != ERROR_SUCCESS || match->ai2.error.type != ERROR_SUCCESS)
+    {
+        state->step = MATCH_STEP_DONE;
+        return;
+    }
+    Match_Setup(state);
+}
+
+static void Match_Setup(BShip_MatchState *state)
+{
+    BShip_MatchData *match = &state->data;
+    state->ai1_seat = BSHIP_PLAYER_1;
+    state->ai2_seat = BSHIP_PLAYER_2;
+    BShip_Message_SetupMatch_Create(&state->ai1_message, match->board_size, state->ai1_seat, state->ai1_framed,
+        state->ai1_encoding);
+    BShip_Message_SetupMatch_Create(&state->ai2_message, match->board_size, state->ai2_seat, state->ai2_framed,
+        state->ai2_encoding);
+    state->phase = MATCH_PHASE_SETUP;
+    state->step = MATCH_STEP_SEND;
+}
+
+static void Match_OnReceiveComplete(BShip_MatchState *state)
+{
+    switch (state->phase)
+    {
+    case MATCH_PHASE_HELLO:
+        Match_OnHelloReceived(state);
+        break;
+    case MATCH_PHASE_PLACING_SHIPS:
+        Game_OnShipsPlaced(state);
+        break;
+    case MATCH_PHASE_TAKING_SHOTS:
+        Game_OnShotsReceived(state);
+        break;
+    case MATCH_PHASE_SETUP:
+    case MATCH_PHASE_SWAPPING_SEATS:
+    case MATCH_PHASE_MATCH_OVER:
+        assert(false);
+        break;
+    }
+}
+
+void Match_OnMessageReceived(BShip_MatchState *state, BShip_PlayerNum player, BShip_ErrorType error)
+{
+    assert(state != NULL);
+    assert(state->step == MATCH_STEP_RECEIVE);
+    if (player == BSHIP_PLAYER_1)
+    {
+        state->ai1_receive_error = error;
+        state->ai1_pending = false;
+    }
+    else
+    {
+        state->ai2_receive_error = error;
+        state->ai2_pending = false;
+    }
+    if (!state->ai1_pending && !state->ai2_pending)
+    {
+        Match_OnReceiveComplete(state);
+    }
+}
+
+void Match_OnSendComplete(BShip_MatchState *state, BShip_ErrorType ai1_error, BShip_ErrorType ai2_error)
+{
+    assert(state != NULL);
+    assert(state->step == MATCH_STEP_SEND);
+    BShip_MatchData *match = &state->data;
+    switch (state->phase)
+    {
+    case MATCH_PHASE_SETUP:
+        match->ai1.error.type = ai1_error;
+        match->ai2.error.type = ai2_error;
+        if (ai1_error != ERROR_SUCCESS || ai2_error != ERROR_SUCCESS)
+        {
+            state->step = MATCH_STEP_DONE;
+            break;
+        }
+        // NOTE(mattg): setup match still goes out the old way, everything after it is framed if the AI asked.
+        BShip_AIConnection_SetFramed(state->ai1_conn, state->ai1_framed);
+        BShip_AIConnection_SetFramed(state->ai2_conn, state->ai2_framed);
+        if (!Match_AllocateGames(state))
+        {
+            Match_Over(state);
+            break;
+        }
+        Game_Begin(state);
+        break;
+    case MATCH_PHASE_SWAPPING_SEATS:
+        // NOTE(mattg): the games so far stay played, an AI that can't be told its seat just ends the match.
+        match->ai1.error.type = ai1_error;
+        match->ai2.error.type = ai2_error;
+        if (ai1_error != ERROR_SUCCESS || ai2_error != ERROR_SUCCESS)
+        {
+            Match_Over(state);
+            break;
+        }
+        Game_Begin(state);
+        break;
+    case MATCH_PHASE_PLACING_SHIPS:
+    case MATCH_PHASE_TAKING_SHOTS:
+        Game_OnSendComplete(state, ai1_error, ai2_error);
+        break;
+    case MATCH_PHASE_MATCH_OVER:
+        // NOTE(mattg): an AI that didn't get match over doesn't know to stay.
+        state->ai1_kept = state->ai1_kept && ai1_error == ERROR_SUCCESS;
+        state->ai2_kept = state->ai2_kept && ai2_error == ERROR_SUCCESS;
+        state->step = MATCH_STEP_DONE;
+        break;
+    case MATCH_PHASE_HELLO:
+        assert(false);
+        break;
+    }
+}
+
+static bool Path_IsPlugin(char *path)
+{
+    size_t length = strlen(path);
+    size_t suffix_length = strlen(BSHIP_PLAYER_PLUGIN_SUFFIX);
+    return length > suffix_length && strcmp(&path[length - suffix_length], BSHIP_PLAYER_PLUGIN_SUFFIX) == 0;
+}
+
+static BShip_ErrorType Player_Load(BShip_Arena *arena, char *path, BShip_Library **library, BShip_Player *player,
+    bool *created)
+{
+    BShip_Library *loaded = BShip_Arena_Push(arena, BShip_Library_GetSize());
+    if (loaded == NULL || !BShip_Library_Open(loaded, path))
+    {
+        return ERROR_AI_PATH_ISSUE;
+    }
+    *library = loaded;
+
+    void *symbol = BShip_Library_GetSymbol(loaded, BSHIP_PLAYER_CREATE_SYMBOL);
+    if (symbol == NULL)
+    {
+        return ERROR_AI_PATH_ISSUE;
+    }
+    // NOTE(mattg): ISO C can't cast an object pointer to a function pointer, so copy it over instead.
+    BShip_Player_CreateProc create = NULL;
+    memcpy(&create, &symbol, sizeof(create));
+
+    memset(player, 0, sizeof(BShip_Player));
+    if (!create(player, BSHIP_PLAYER_ABI_VERSION))
+    {
+        PRINT_ERROR_F("Plugin %s couldn't create a player (ABI version %d)", path, BSHIP_PLAYER_ABI_VERSION);
+        return ERROR_PROCESS_FAILED;
+    }
+    *created = true;
+    if (player->setup_match == NULL || player->start_game == NULL || player->choose_ship_placements == NULL ||
+        player->choose_shot == NULL || player->handle_shot_result == NULL || player->handle_ship_dead == NULL ||
+        player->handle_game_over == NULL || player->handle_match_over == NULL || player->destroy == NULL)
+    {
+        PRINT_ERROR_F("Plugin %s left out some of the player functions", path);
+        return ERROR_PROCESS_FAILED;
+    }
+    return ERROR_SUCCESS;
+}
+
+static void Player_Unload(BShip_Library **library, BShip_Player *player, bool *created)
+{
+    if (*created && player->destroy != NULL)
+    {
+        player->destroy(player->data);
+    }
+    *created = false;
+    if (*library != NULL)
+    {
+        BShip_Library_Close(*library);
+        *library = NULL;
+    }
+}
+
+static void Player_CopyName(char *dest, const char *source)
+{
+    if (source != NULL)
+    {
+        strncpy(dest, source, BSHIP_MESSAGE_NAME_SIZE_MAX - 1);
+    }
+}
+
+// Plays the whole match between two in-process players, from setup match to match over, until the games are full
+// or one of them makes a mistake. Only the ships and shots of each game stay in the arena, unless they go to a sink.
+static void Match_Simulate(BShip_Arena *arena, BShip_Player *player1, BShip_Player *player2,
+    const BShip_GameSink *sink, BShip_MatchData *match)
+{
+    const BShip_BoardRules *rules = BoardRules_Get(match->board_size);
+    player1->setup_match(player1->data, BSHIP_PLAYER_1, match->board_size);
+    player2->setup_match(player2->data, BSHIP_PLAYER_2, match->board_size);
+
+    BShip_GameState game;
+    uint8_t pair_ship_lengths[BSHIP_SHIP_COUNT_MAX];
+    BShip_GameResult pair_first_result = BSHIP_TIE;
+    bool playing = Match_HasGamesLeft(match, sink);
+    while (playing)
+    {
+        if (!Match_AllocateGame(match, &game, arena, rules, pair_ship_lengths))
+        {
+            break;
+        }
+        // NOTE(mattg): players can always be set up again, so both swap seats between the games of a paired match.
+        if (match->paired && match->games_played > 0)
+        {
+            BShip_PlayerNum player1_seat = game.seats_swapped ? BSHIP_PLAYER_2 : BSHIP_PLAYER_1;
+            player1->setup_match(player1->data, player1_seat, match->board_size);
+            player2->setup_match(player2->data, PlayerNum_Other(player1_seat), match->board_size);
+        }
+        Game_Simulate(&game, player1, player2);
+        playing = Match_StoreGame(match, sink, arena, &game, &pair_first_result);
+    }
+
+    player1->handle_match_over(player1->data);
+    player2->handle_match_over(player2->data);
+}
+
+static void Match_PlayInProcess(BShip_MatchState *state)
+{
+    // NOTE(mattg): out of memory for the games still gets the players through setup and match over.
+    Match_AllocateGames(state);
+    Match_Simulate(state->arena, &state->ai1_player, &state->ai2_player, &state->sink, &state->data);
+    state->phase = MATCH_PHASE_MATCH_OVER;
+    state->step = MATCH_STEP_DONE;
+}
+
+// Tells an AI that isn't kept to exit by closing its socket, and has the reactor wait on it. Returns false when
+// there is nothing to wait on, or the reactor can't, Match_Finish then waits on it the blocking way.
+static bool MatchAI_BeginExit(BShip_Reactor *reactor, BShip_AIPoolEntry *entry, bool kept, bool debug)
+{
+    if (entry == NULL || kept || !entry->started)
+    {
+        return false;
+    }
+    if (!BShip_Reactor_ExpectExit(reactor, entry->conn, debug))
+    {
+        return false;
+    }
+    AIPoolEntry_Close(entry);
+    return true;
+}
+
+// NOTE(mattg): both AIs that aren't kept are told to exit before waiting on either of them, and the wait goes
+// through the reactor, so the worker keeps serving its other matches in the meantime.
+static void Match_BeginExit(BShip_Reactor *reactor, BShip_MatchState *state)
+{
+    state->exit_begun = true;
+    if (!state->registered)
+    {
+        return;
+    }
+    // NOTE(mattg): a match that ended before match over (like a failed setup) wasn't sampled in Match_Over yet.
+    if (!state->data.ai1.usage.measured)
+    {
+        BShip_AIConnection_SampleUsage(state->ai1_conn, &state->data.ai1.usage);
+    }
+    if (!state->data.ai2.usage.measured)
+    {
+        BShip_AIConnection_SampleUsage(state->ai2_conn, &state->data.ai2.usage);
+    }
+    state->ai1_exiting = MatchAI_BeginExit(reactor, state->ai1_entry, state->ai1_kept, state->debug);
+    state->ai2_exiting = MatchAI_BeginExit(reactor, state->ai2_entry, state->ai2_kept, state->debug);
+    if (state->ai1_exiting || state->ai2_exiting)
+    {
+        state->step = MATCH_STEP_EXIT;
+    }
+}
+
+static void Match_OnExit(BShip_MatchState *state, bool is_ai1, bool timed_out)
+{
+    if (is_ai1)
+    {
+        state->ai1_exiting = false;
+        state->ai1_exit_timed_out = timed_out;
+    }
+    else
+    {
+        state->ai2_exiting = false;
+        state->ai2_exit_timed_out = timed_out;
+    }
+    if (!state->ai1_exiting && !state->ai2_exiting)
+    {
+        state->step = MATCH_STEP_DONE;
+    }
+}
+
+// Sends whatever the match is waiting to send, until it is waiting on the AIs (or done).
+// NOTE(mattg): sends only ever wait for room in the socket, which for a message this small is right away.
+void Match_Advance(BShip_Reactor *reactor, BShip_MatchState *state)
+{
+    assert(reactor != NULL);
+    assert(state != NULL);
+    if (state->in_process)
+    {
+        if (state->step != MATCH_STEP_DONE)
+        {
+            Match_PlayInProcess(state);
+        }
+        return;
+    }
+    while (state->step == MATCH_STEP_SEND)
+    {
+        BShip_ErrorType ai1_error = ERROR_SUCCESS, ai2_error = ERROR_SUCCESS;
+        // NOTE(mattg): an AI that already failed at the match level doesn't get any more messages.
+        if (state->data.ai1.error.type == ERROR_SUCCESS && state->ai1_message.length > 0)
+        {
+            ai1_error = BShip_AIConnection_Send(state->ai1_conn, state->ai1_message, state->debug);
+        }
+        if (state->data.ai2.error.type == ERROR_SUCCESS && state->ai2_message.length > 0)
+        {
+            ai2_error = BShip_AIConnection_Send(state->ai2_conn, state->ai2_message, state->debug);
+        }
+        Match_OnSendComplete(state, ai1_error, ai2_error);
+    }
+    if (state->step == MATCH_STEP_RECEIVE && !state->ai1_pending && !state->ai2_pending)
+    {
+        // NOTE(mattg): only one of the AIs says hello when the other one was reused.
+        bool hello = state->phase == MATCH_PHASE_HELLO;
+        state->ai1_pending = !hello || !state->data.ai1.reused;
+        state->ai2_pending = !hello || !state->data.ai2.reused;
+        if (state->ai1_pending)
+        {
+            BShip_Reactor_Expect(reactor, state->ai1_conn, state->debug);
+        }
+        if (state->ai2_pending)
+        {
+            BShip_Reactor_Expect(reactor, state->ai2_conn, state->debug);
+        }
+    }
+    if (state->step == MATCH_STEP_DONE && !state->exit_begun)
+    {
+        Match_BeginExit(reactor, state);
+    }
+}
+
+void Match_OnEvent(BShip_MatchState *state, BShip_ReactorEvent event)
+{
+    assert(state != NULL);
+    if (state->step == MATCH_STEP_EXIT)
+    {
+        bool is_ai1 = event.ai_conn == state->ai1_conn;
+        if ((is_ai1 && state->ai1_exiting) || (!is_ai1 && state->ai2_exiting))
+        {
+            Match_OnExit(state, is_ai1, event.type != BSHIP_REACTOR_EXITED);
+        }
+        return;
+    }
+    if (state->step != MATCH_STEP_RECEIVE)
+    {
+        return;
+    }
+    bool is_ai1 = event.ai_conn == state->ai1_conn;
+    if ((is_ai1 && !state->ai1_pending) || (!is_ai1 && !state->ai2_pending))
+    {
+        return;
+    }
+
+    BShip_ErrorType error = ERROR_RECEIVE_TIMEOUT;
+    if (event.type == BSHIP_REACTOR_READABLE)
+    {
+        error = BShip_AIConnection_Read(event.ai_conn, is_ai1 ? &state->ai1_message : &state->ai2_message);
+    }
+    else
+    {
+        PRINT_ERROR("Waiting on a message from the AI timed out!");
+    }
+    Match_OnMessageReceived(state, is_ai1 ? BSHIP_PLAYER_1 : BSHIP_PLAYER_2, error);
+}
+
+void Match_OnWaitFailed(BShip_MatchState *state)
+{
+    assert(state != NULL);
+    if (state->step == MATCH_STEP_EXIT)
+    {
+        // NOTE(mattg): the AIs still running get killed.
+        if (state->ai1_exiting)
+        {
+            Match_OnExit(state, true, true);
+        }
+        if (state->ai2_exiting)
+        {
+            Match_OnExit(state, false, true);
+        }
+        return;
+    }
+    if (state->step != MATCH_STEP_RECEIVE)
+    {
+        return;
+    }
+    if (state->ai1_pending)
+    {
+        Match_OnMessageReceived(state, BSHIP_PLAYER_1, ERROR_RECEIVE_FAILED);
+    }
+    if (state->ai2_pending)
+    {
+        Match_OnMessageReceived(state, BSHIP_PLAYER_2, ERROR_RECEIVE_FAILED);
+    }
+}
+
+// Gets an AI from the pool, or the match's own entry when there's no pool or it's full. Returns NULL when out of
+// memory. An entry that is already started is a reused AI, waiting for its setup match.
+static BShip_AIPoolEntry *Match_AcquireAI(BShip_MatchState *state, BShip_AIPoolEntry *own_entry, char *path,
+    char *dir)
+{
+    if (state->pool != NULL)
+    {
+        BShip_AIPoolEntry *entry = AIPool_Acquire(state->pool, path, dir, state->debug);
+        if (entry != NULL)
+        {
+            return entry;
+        }
+    }
+    memset(own_entry, 0, sizeof(BShip_AIPoolEntry));
+    own_entry->conn = BShip_Arena_Push(state->arena, BShip_AIConnection_GetSize());
+    own_entry->path = path;
+    own_entry->dir = dir;
+    own_entry->state = AI_POOL_ENTRY_IN_USE;
+    return own_entry->conn != NULL ? own_entry : NULL;
+}
+
+// Starts the AI and waits for it to connect.
+// NOTE(mattg): both AIs connect to the same named socket, so the first one has to be accepted before the second one
+// is started, or ai1 could be handed ai2's connection. That never mattered much when both were closed after the
+// match, but a pooled AI has to be the one its path says. Socket pairs are connected as soon as they are started, and
+// so are AIs forked from a zygote.
+static BShip_ErrorType MatchAI_Connect(BShip_AIPoolEntry *entry, BShip_Connection *conn, char *socket_path,
+    bool debug)
+{
+    if (entry->pool != NULL && AIPool_Fork(entry->pool, entry, debug))
+    {
+        return ERROR_SUCCESS;
+    }
+    BShip_ErrorType error = BShip_AIConnection_StartProcess(entry->conn, socket_path, entry->path, entry->dir);
+    entry->started = true;
+    if (error != ERROR_SUCCESS)
+    {
+        return error;
+    }
+    return BShip_AIConnection_Accept(entry->conn, conn, debug);
+}
+
+static void MatchAI_LoadHello(BShip_AIPoolEntry *entry, BShip_AIMatchData *ai, bool *framed,
+    BShip_MessageEncoding *encoding)
+{
+    if (!entry->started)
+    {
+        return;
+    }
+    memcpy(ai->name, entry->name, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    memcpy(ai->authors, entry->authors, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    *framed = entry->framed;
+    *encoding = entry->encoding;
+}
+
+// Takes off what a reused AI had already used before this match. When that wasn't measured, neither is this match.
+static void Match_SubtractUsage(BShip_AIUsage *usage, BShip_AIUsage *base, bool reused)
+{
+    if (!reused)
+    {
+        return;
+    }
+    if (!base->measured)
+    {
+        memset(usage, 0, sizeof(BShip_AIUsage));
+        return;
+    }
+    // NOTE(mattg): the sample and wait4() can disagree a little (see Process_GetUsage), so don't go below 0.
+    usage->user_seconds = usage->user_seconds > base->user_seconds ? usage->user_seconds - base->user_seconds : 0.0;
+    usage->system_seconds = usage->system_seconds > base->system_seconds
+        ? usage->system_seconds - base->system_seconds : 0.0;
+    usage->voluntary_context_switches = usage->voluntary_context_switches > base->voluntary_context_switches
+        ? usage->voluntary_context_switches - base->voluntary_context_switches : 0;
+    usage->involuntary_context_switches = usage->involuntary_context_switches > base->involuntary_context_switches
+        ? usage->involuntary_context_switches - base->involuntary_context_switches : 0;
+}
+
+static void Match_ReleaseAI(BShip_MatchState *state, BShip_AIPoolEntry **entry, BShip_AIMatchData *ai, bool keep,
+    bool exit_timed_out)
+{
+    if (*entry == NULL)
+    {
+        return;
+    }
+    BShip_AIConnection *conn = (*entry)->conn;
+    BShip_AIUsage base = (*entry)->usage_base;
+    if (exit_timed_out)
+    {
+        // NOTE(mattg): it already had its time to exit in the reactor, so it doesn't get another wait.
+        BShip_AIConnection_KillProcess(conn);
+    }
+    if ((*entry)->pool != NULL)
+    {
+        AIPool_Release((*entry)->pool, *entry, keep, state->debug);
+    }
+    else
+    {
+        AIPoolEntry_Stop(*entry, state->debug);
+    }
+    BShip_AIUsage exited;
+    if (BShip_AIConnection_GetUsage(conn, &exited))
+    {
+        ai->usage = exited;
+    }
+    if (keep)
+    {
+        // NOTE(mattg): a kept entry stays the pool's, and is only touched again by the match that reuses it.
+        (*entry)->usage_base = ai->usage;
+    }
+    Match_SubtractUsage(&ai->usage, &base, ai->reused);
+    *entry = NULL;
+}
+
+size_t Match_CalculateStateSize(void)
+{
+    return sizeof(BShip_MatchState) + (BSHIP_MESSAGE_NAME_SIZE_MAX * 4) + (BSHIP_MESSAGE_SIZE * 4)
+        + BShip_Connection_GetSize() + (BShip_AIConnection_GetSize() * 2) + Message_CalculateParseMemorySize()
+        + (BShip_Library_GetSize() * 2);
+}
+
+// Starts both AI processes and connects to them. Returns NULL only when out of memory, any other error is stored
+// in the match, which is then already done. Either way, Match_Finish has to be called on it.
+BShip_MatchState *Match_Start(BShip_Arena *arena, BShip_Reactor *reactor, char *socket_path,
+    char *ai1_path, char *ai1_dir, char *ai2_path, char *ai2_dir,
+    uint8_t board_size, uint32_t games_per_match, float stop_confidence, bool paired, BShip_GameSink *sink,
+    BShip_AIPool *pool, bool debug)
+{
+    assert(arena != NULL);
+    assert(reactor != NULL);
+    BShip_MatchState *state = BSHIP_ARENA_PUSH(arena, BShip_MatchState);
+    if (state == NULL)
+    {
+        return state;
+    }
+    memset(state, 0, sizeof(BShip_MatchState));
+    state->arena = arena;
+    state->pool = pool;
+    state->debug = debug;
+    if (sink != NULL)
+    {
+        state->sink = *sink;
+    }
+    state->step = MATCH_STEP_DONE;
+    state->start_time = BShip_Time_GetSeconds();
+
+    BShip_MatchData *match = &state->data;
+    match->games_per_match = games_per_match;
+    match->stop_confidence = stop_confidence;
+    match->paired = paired;
+    match->confidence = 0.5f;
+    match->board_size = board_size;
+    state->rules = BoardRules_Get(board_size);
+
+    match->ai1.error.message.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_SIZE);
+    match->ai2.error.message.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_SIZE);
+    match->ai1.name = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    match->ai1.authors = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    match->ai2.name = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    match->ai2.authors = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    state->ai1_message.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_SIZE);
+    state->ai2_message.buffer = BSHIP_ARENA_PUSH_ARRAY(arena, char, BSHIP_MESSAGE_SIZE);
+    if (match->ai1.error.message.buffer == NULL || match->ai2.error.message.buffer == NULL ||
+        match->ai1.name == NULL || match->ai1.authors == NULL ||
+        match->ai2.name == NULL || match->ai2.authors == NULL ||
+        state->ai1_message.buffer == NULL || state->ai2_message.buffer == NULL)
+    {
+        return state;
+    }
+    memset(match->ai1.error.message.buffer, 0, BSHIP_MESSAGE_SIZE);
+    memset(match->ai2.error.message.buffer, 0, BSHIP_MESSAGE_SIZE);
+    memset(match->ai1.name, 0, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    memset(match->ai1.authors, 0, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    memset(match->ai2.name, 0, BSHIP_MESSAGE_NAME_SIZE_MAX);
+    memset(match->ai2.authors, 0, BSHIP_MESSAGE_NAME_SIZE_MAX);
+
+    // NOTE(mattg): plugins are played in process, which only works when both of them are. They don't get a dir.
+    bool ai1_plugin = Path_IsPlugin(ai1_path), ai2_plugin = Path_IsPlugin(ai2_path);
+    if (ai1_plugin || ai2_plugin)
+    {
+        if (!ai1_plugin || !ai2_plugin)
+        {
+            PRINT_ERROR("A plugin AI can only play against another plugin AI!");
+            match->ai1.error.type = ai1_plugin ? ERROR_AI_PATH_ISSUE : ERROR_SUCCESS;
+            match->ai2.error.type = ai2_plugin ? ERROR_AI_PATH_ISSUE : ERROR_SUCCESS;
+            return state;
+        }
+        state->in_process = true;
+        match->ai1.error.type = Player_Load(arena, ai1_path, &state->ai1_library, &state->ai1_player,
+            &state->ai1_player_created);
+        match->ai2.error.type = Player_Load(arena, ai2_path, &state->ai2_library, &state->ai2_player,
+            &state->ai2_player_created);
+        if (match->ai1.error.type != ERROR_SUCCESS || match->ai2.error.type != ERROR_SUCCESS)
+        {
+            return state;
+        }
+        Player_CopyName(match->ai1.name, state->ai1_player.name);
+        Player_CopyName(match->ai1.authors, state->ai1_player.authors);
+        Player_CopyName(match->ai2.name, state->ai2_player.name);
+        Player_CopyName(match->ai2.authors, state->ai2_player.authors);
+        state->phase = MATCH_PHASE_SETUP;
+        state->step = MATCH_STEP_SEND;
+        return state;
+    }
+
+    bool ai1_path_ok = BShip_PathIsExecutable(ai1_path) && BShip_PathIsDirectory(ai1_dir);
+    bool ai2_path_ok = BShip_PathIsExecutable(ai2_path) && BShip_PathIsDirectory(ai2_dir);
+    if (!ai1_path_ok || !ai2_path_ok)
+    {
+        match->ai1.error.type = ai1_path_ok ? ERROR_SUCCESS : ERROR_AI_PATH_ISSUE;
+        match->ai2.error.type = ai2_path_ok ? ERROR_SUCCESS : ERROR_AI_PATH_ISSUE;
+        return state;
+    }
+
+    state->ai1_entry = Match_AcquireAI(state, &state->ai1_own_entry, ai1_path, ai1_dir);
+    state->ai2_entry = Match_AcquireAI(state, &state->ai2_own_entry, ai2_path, ai2_dir);
+    if (state->ai1_entry == NULL || state->ai2_entry == NULL)
+    {
+        return state;
+    }
+    BShip_AIConnection *ai1_conn = state->ai1_entry->conn;
+    BShip_AIConnection *ai2_conn = state->ai2_entry->conn;
+    state->ai1_conn = ai1_conn;
+    state->ai2_conn = ai2_conn;
+    match->ai1.reused = state->ai1_entry->started;
+    match->ai2.reused = state->ai2_entry->started;
+    MatchAI_LoadHello(state->ai1_entry, &match->ai1, &state->ai1_framed, &state->ai1_encoding);
+    MatchAI_LoadHello(state->ai2_entry, &match->ai2, &state->ai2_framed, &state->ai2_encoding);
+
+    if (!match->ai1.reused || !match->ai2.reused)
+    {
+        BShip_Connection *conn = BShip_Arena_Push(arena, BShip_Connection_GetSize());
+        if (conn == NULL)
+        {
+            return state;
+        }
+        if (!BShip_Connection_Create(conn, socket_path))
+        {
+            return state;
+        }
+        state->conn = conn;
+    }
+
+    if (!match->ai1.reused)
+    {
+        match->ai1.error.type = MatchAI_Connect(state->ai1_entry, state->conn, socket_path, debug);
+        if (match->ai1.error.type != ERROR_SUCCESS)
+        {
+            return state;
+        }
+    }
+    if (!match->ai2.reused)
+    {
+        match->ai2.error.type = MatchAI_Connect(state->ai2_entry, state->conn, socket_path, debug);
+        if (match->ai2.error.type != ERROR_SUCCESS)
+        {
+            return state;
+        }
+    }
+
+    if (!BShip_Reactor_Add(reactor, ai1_conn, state))
+    {
+        match->ai1.error.type = ERROR_CONNECTION_FAILED;
+        return state;
+    }
+    if (!BShip_Reactor_Add(reactor, ai2_conn, state))
+    {
+        BShip_Reactor_Remove(reactor, ai1_conn);
+        match->ai2.error.type = ERROR_CONNECTION_FAILED;
+        return state;
+    }
+    state->registered = true;
+
+    if (match->ai1.reused && match->ai2.reused)
+    {
+        Match_Setup(state);
+        return state;
+    }
+    state->phase = MATCH_PHASE_HELLO;
+    state->step = MATCH_STEP_RECEIVE;
+    return state;
+}
+
+BShip_MatchData Match_Finish(BShip_Reactor *reactor, BShip_MatchState *state)
+{
+    assert(reactor != NULL);
+    assert(state != NULL);
+    if (state->in_process)
+    {
+        Player_Unload(&state->ai1_library, &state->ai1_player, &state->ai1_player_created);
+        Player_Unload(&state->ai2_library, &state->ai2_player, &state->ai2_player_created);
+    }
+    if (state->registered)
+    {
+        BShip_Reactor_Remove(reactor, state->ai1_conn);
+        BShip_Reactor_Remove(reactor, state->ai2_conn);
+        state->registered = false;
+    }
+    if (state->ai1_entry != NULL || state->ai2_entry != NULL)
+    {
+        // NOTE(mattg): the ones the reactor didn't wait on (in Match_BeginExit) are told to exit here.
+        if (state->ai1_entry != NULL && !state->ai1_kept)
+        {
+            AIPoolEntry_Close(state->ai1_entry);
+        }
+        if (state->ai2_entry != NULL && !state->ai2_kept)
+        {
+            AIPoolEntry_Close(state->ai2_entry);
+        }
+        Match_ReleaseAI(state, &state->ai1_entry, &state->data.ai1, state->ai1_kept, state->ai1_exit_timed_out);
+        Match_ReleaseAI(state, &state->ai2_entry, &state->data.ai2, state->ai2_kept, state->ai2_exit_timed_out);
+    }
+    if (state->conn != NULL)
+    {
+        BShip_Connection_Close(state->conn);
+        state->conn = NULL;
+    }
+    state->data.elapsed_time = (float)(BShip_Time_GetSeconds() - state->start_time);
+    return state->data;
+}
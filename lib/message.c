@@ -21,6 +21,40 @@
 #define SHIP_KEY         "sp"
 #define SHOT_KEY         "st"
 #define NEXT_SHOT_KEY    "ns"
+#define FRAMING_KEY      "fr"
+#define ENCODING_KEY     "en"
+#define NEW_MATCH_KEY    "nm"
+#define ZYGOTE_KEY       "zy"
+
+// NOTE(mattg): an AI that puts this in its hello gets every message after setup match as a length prefixed frame,
+// and must send its own that way. Setup match repeats it, so the AI knows the controller understood.
+#define FRAMING_LENGTH_PREFIXED 1
+
+// NOTE(mattg): a framed AI can also ask for this, and then ships placed, shot taken and shot result are sent as the
+// fixed byte layouts below instead of JSON. Every field fits in a byte, so there's no endianness to worry about.
+// Place ships and match over stay JSON, the AI can tell them apart since JSON always starts with '{'.
+#define ENCODING_BINARY 1
+
+// NOTE(mattg): an AI that puts this in its hello can play more than one match without exiting. Match over repeats it
+// when the controller keeps the AI running, and the AI then waits for the setup match of its next match (sent the
+// old way, like the first one) or for the socket to close.
+#define NEW_MATCH_SUPPORTED 1
+
+// NOTE(mattg): an AI that puts this in its hello can be started as a zygote (see BShip_AIZygote), and from then on
+// each of its matches is played by a fresh copy forked from it, which says hello again.
+#define ZYGOTE_SUPPORTED 1
+
+// ships placed: type, ship count, then row, column, length, direction for each ship.
+#define BINARY_SHIP_SIZE 4
+#define BINARY_SHIPS_PLACED_HEADER_SIZE 2
+// shot taken: type, row, column.
+#define BINARY_SHOT_TAKEN_SIZE 3
+// shot result: type, flags, row, column, value for each shot, then row, column, length, direction for each ship.
+#define BINARY_SHOT_SIZE 3
+#define BINARY_SHOT_RESULT_SIZE (2 + (BINARY_SHOT_SIZE * 2) + (BINARY_SHIP_SIZE * 2))
+#define BINARY_SHOT_RESULT_NEXT_SHOT 0x1
+#define BINARY_SHOT_RESULT_AI1_SHIP  0x2
+#define BINARY_SHOT_RESULT_AI2_SHIP  0x4
 
 typedef enum {
     MESSAGE_HELLO,
@@ -32,13 +66,149 @@ typedef enum {
     MESSAGE_MATCH_OVER,
 } BShip_MessageType;
 
-BShip_ErrorType BShip_Message_Hello_Parse(BShip_Message message, char *ai_name, char *author_names)
+typedef enum {
+    MESSAGE_ENCODING_JSON,
+    MESSAGE_ENCODING_BINARY,
+} BShip_MessageEncoding;
+
+// NOTE(mattg): every message the controller sends is small and always the same shape, so they're written straight
+// into the message buffer. Building a yyjson document for them means a handful of mallocs and a copy, on every shot.
+typedef struct {
+    char *buffer;
+    uint32_t length;
+} BShip_MessageWriter;
+
+#define MESSAGE_WRITER_LITERAL(writer, literal) \
+    MessageWriter_Bytes(writer, literal, sizeof(literal) - 1)
+#define MESSAGE_WRITER_KEY(writer, key) \
+    MESSAGE_WRITER_LITERAL(writer, "\"" key "\":")
+
+static inline void MessageWriter_Bytes(BShip_MessageWriter *writer, const char *bytes, uint32_t count)
+{
+    assert(writer->length + count < BSHIP_MESSAGE_SIZE);
+    memcpy(&writer->buffer[writer->length], bytes, count);
+    writer->length += count;
+}
+
+static inline void MessageWriter_Char(BShip_MessageWriter *writer, char c)
+{
+    assert(writer->length + 1 < BSHIP_MESSAGE_SIZE);
+    writer->buffer[writer->length++] = c;
+}
+
+static void MessageWriter_Uint(BShip_MessageWriter *writer, uint32_t value)
+{
+    char digits[10];
+    uint32_t count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value > 0);
+
+    assert(writer->length + count < BSHIP_MESSAGE_SIZE);
+    while (count > 0)
+    {
+        writer->buffer[writer->length++] = digits[--count];
+    }
+}
+
+static void MessageWriter_Ship(BShip_MessageWriter *writer, BShip_Ship *ship)
 {
+    if (ship == NULL)
+    {
+        MESSAGE_WRITER_LITERAL(writer, "null");
+        return;
+    }
+    MessageWriter_Char(writer, '[');
+    MessageWriter_Uint(writer, ship->row);
+    MessageWriter_Char(writer, ',');
+    MessageWriter_Uint(writer, ship->column);
+    MessageWriter_Char(writer, ',');
+    MessageWriter_Uint(writer, ship->length);
+    MessageWriter_Char(writer, ',');
+    MessageWriter_Uint(writer, ship->direction);
+    MessageWriter_Char(writer, ']');
+}
+
+static void MessageWriter_Shot(BShip_MessageWriter *writer, BShip_Shot shot)
+{
+    MessageWriter_Char(writer, '[');
+    MessageWriter_Uint(writer, shot.row);
+    MessageWriter_Char(writer, ',');
+    MessageWriter_Uint(writer, shot.column);
+    MessageWriter_Char(writer, ',');
+    MessageWriter_Uint(writer, shot.value);
+    MessageWriter_Char(writer, ']');
+}
+
+static void MessageWriter_Finish(BShip_MessageWriter *writer, BShip_Message *message)
+{
+    assert(writer->length < BSHIP_MESSAGE_SIZE);
+    // NOTE(mattg): unframed AIs get the whole buffer, so the rest of it has to be zeros.
+    memset(&writer->buffer[writer->length], 0, BSHIP_MESSAGE_SIZE - writer->length);
+    message->length = (uint8_t)writer->length;
+}
+
+// NOTE(mattg): incoming messages are parsed out of the match's arena, and each parse function rolls it back before it
+// returns, so there's nothing to free. Any realloc yyjson does just leaves the old memory behind until then.
+static void *MessageArena_Malloc(void *ctx, size_t size)
+{
+    return BShip_Arena_Push((BShip_Arena *)ctx, size);
+}
+
+static void *MessageArena_Realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+    void *memory = BShip_Arena_Push((BShip_Arena *)ctx, size);
+    if (memory != NULL && ptr != NULL)
+    {
+        memcpy(memory, ptr, old_size < size ? old_size : size);
+    }
+    return memory;
+}
+
+static void MessageArena_Free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    (void)ptr;
+}
+
+// The most arena a parse can use, so a match's arena can hold it without growing a new block every message.
+static inline size_t Message_CalculateParseMemorySize(void)
+{
+    // realloc never gives anything back, so this leaves room for yyjson to grow its buffers a few times.
+    return (yyjson_read_max_memory_usage(BSHIP_MESSAGE_SIZE, 0) * 2) + 256;
+}
+
+static yyjson_doc *Message_Read(BShip_Arena *arena, BShip_Message message)
+{
+    yyjson_alc allocator = {
+        .malloc = MessageArena_Malloc,
+        .realloc = MessageArena_Realloc,
+        .free = MessageArena_Free,
+        .ctx = arena,
+    };
+    return yyjson_read_opts(message.buffer, message.length, 0, &allocator, NULL);
+}
+
+BShip_ErrorType BShip_Message_Hello_Parse(BShip_Arena *arena, BShip_Message message, char *ai_name,
+    char *author_names, bool *framed, BShip_MessageEncoding *encoding, bool *new_match, bool *zygote)
+{
+    assert(arena != NULL);
     assert(message.buffer != NULL);
     assert(ai_name != NULL);
     assert(author_names != NULL);
-
-    yyjson_doc *doc = yyjson_read(message.buffer, strlen(message.buffer), 0);
+    assert(framed != NULL);
+    assert(encoding != NULL);
+    assert(new_match != NULL);
+    assert(zygote != NULL);
+    *framed = false;
+    *encoding = MESSAGE_ENCODING_JSON;
+    *new_match = false;
+    *zygote = false;
+
+    BSHIP_ARENA_TEMP_BEGIN(arena);
+    yyjson_doc *doc = Message_Read(arena, message);
     if (doc == NULL) goto on_error;
 
     yyjson_val *root = yyjson_doc_get_root(doc);
@@ -52,57 +222,87 @@ BShip_ErrorType BShip_Message_Hello_Parse(BShip_Message message, char *ai_name,
         yyjson_val *obj = yyjson_obj_get(root, AI_NAME_KEY);
         if (!yyjson_is_str(obj)) goto on_error;
         size_t ai_name_len = yyjson_get_len(obj);
-        if (ai_name_len > BSHIP_MESSAGE_NAME_SIZE_MAX)
+        if (ai_name_len > BSHIP_MESSAGE_NAME_SIZE_MAX - 1)
         {
-            ai_name_len = BSHIP_MESSAGE_NAME_SIZE_MAX;
+            ai_name_len = BSHIP_MESSAGE_NAME_SIZE_MAX - 1;
         }
         const char *ai_name_input = yyjson_get_str(obj);
         strncpy(ai_name, ai_name_input, ai_name_len);
+        ai_name[ai_name_len] = '\0';
     }
     {
         yyjson_val *obj = yyjson_obj_get(root, AUTHOR_NAMES_KEY);
         if (!yyjson_is_str(obj)) goto on_error;
         size_t author_names_len = yyjson_get_len(obj);
-        if (author_names_len > BSHIP_MESSAGE_NAME_SIZE_MAX)
+        if (author_names_len > BSHIP_MESSAGE_NAME_SIZE_MAX - 1)
         {
-            author_names_len = BSHIP_MESSAGE_NAME_SIZE_MAX;
+            author_names_len = BSHIP_MESSAGE_NAME_SIZE_MAX - 1;
         }
         const char *author_names_input = yyjson_get_str(obj);
         strncpy(author_names, author_names_input, author_names_len);
+        author_names[author_names_len] = '\0';
+    }
+    {
+        yyjson_val *obj = yyjson_obj_get(root, FRAMING_KEY);
+        *framed = yyjson_is_uint(obj) && yyjson_get_uint(obj) == FRAMING_LENGTH_PREFIXED;
+    }
+    {
+        // NOTE(mattg): binary messages can't be found by their null terminator, so they need the frame length.
+        yyjson_val *obj = yyjson_obj_get(root, ENCODING_KEY);
+        if (*framed && yyjson_is_uint(obj) && yyjson_get_uint(obj) == ENCODING_BINARY)
+        {
+            *encoding = MESSAGE_ENCODING_BINARY;
+        }
+    }
+    {
+        yyjson_val *obj = yyjson_obj_get(root, NEW_MATCH_KEY);
+        *new_match = yyjson_is_uint(obj) && yyjson_get_uint(obj) == NEW_MATCH_SUPPORTED;
+    }
+    {
+        yyjson_val *obj = yyjson_obj_get(root, ZYGOTE_KEY);
+        *zygote = yyjson_is_uint(obj) && yyjson_get_uint(obj) == ZYGOTE_SUPPORTED;
     }
 
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_SUCCESS;
 on_error:
     PRINT_ERROR_F("Invalid \"Hello\" message received: <%s>", message.buffer);
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_MESSAGE_HELLO_INVALID;
 }
 
-void BShip_Message_SetupMatch_Create(BShip_Message *message, uint8_t board_size, BShip_PlayerNum player_num)
+void BShip_Message_SetupMatch_Create(BShip_Message *message, uint8_t board_size, BShip_PlayerNum player_num,
+    bool framed, BShip_MessageEncoding encoding)
 {
     assert(message != NULL);
     assert(message->buffer != NULL);
     assert(board_size >= BSHIP_BOARD_SIZE_MIN);
     assert(board_size <= BSHIP_BOARD_SIZE_MAX);
-    memset(message->buffer, 0, BSHIP_MESSAGE_SIZE);
-
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    yyjson_mut_val *root = yyjson_mut_obj(doc);
-    yyjson_mut_doc_set_root(doc, root);
 
-    yyjson_mut_obj_add_int(doc, root, MESSAGE_TYPE_KEY, MESSAGE_SETUP_MATCH);
-    yyjson_mut_obj_add_int(doc, root, BOARD_SIZE_KEY, board_size);
-    yyjson_mut_obj_add_int(doc, root, PLAYER_NUM_KEY, player_num);
-
-    size_t length = 0;
-    char *json = yyjson_mut_write(doc, 0, &length);
-    assert(length < BSHIP_MESSAGE_SIZE);
-
-    strncpy(message->buffer, json, length);
-
-    free(json);
-    yyjson_mut_doc_free(doc);
+    BShip_MessageWriter writer = { .buffer = message->buffer };
+    MessageWriter_Char(&writer, '{');
+    MESSAGE_WRITER_KEY(&writer, MESSAGE_TYPE_KEY);
+    MessageWriter_Uint(&writer, MESSAGE_SETUP_MATCH);
+    MessageWriter_Char(&writer, ',');
+    MESSAGE_WRITER_KEY(&writer, BOARD_SIZE_KEY);
+    MessageWriter_Uint(&writer, board_size);
+    MessageWriter_Char(&writer, ',');
+    MESSAGE_WRITER_KEY(&writer, PLAYER_NUM_KEY);
+    MessageWriter_Uint(&writer, player_num);
+    if (framed)
+    {
+        MessageWriter_Char(&writer, ',');
+        MESSAGE_WRITER_KEY(&writer, FRAMING_KEY);
+        MessageWriter_Uint(&writer, FRAMING_LENGTH_PREFIXED);
+    }
+    if (encoding == MESSAGE_ENCODING_BINARY)
+    {
+        MessageWriter_Char(&writer, ',');
+        MESSAGE_WRITER_KEY(&writer, ENCODING_KEY);
+        MessageWriter_Uint(&writer, ENCODING_BINARY);
+    }
+    MessageWriter_Char(&writer, '}');
+    MessageWriter_Finish(&writer, message);
 }
 
 void BShip_Message_PlaceShips_Create(BShip_Message *message, uint8_t *ship_lengths, uint8_t ship_count)
@@ -112,14 +312,14 @@ void BShip_Message_PlaceShips_Create(BShip_Message *message, uint8_t *ship_lengt
     assert(ship_lengths != NULL);
     assert(ship_count >= BSHIP_SHIP_COUNT_MIN);
     assert(ship_count <= BSHIP_SHIP_COUNT_MAX);
-    memset(message->buffer, 0, BSHIP_MESSAGE_SIZE);
 
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    yyjson_mut_val *root = yyjson_mut_obj(doc);
-    yyjson_mut_doc_set_root(doc, root);
-
-    yyjson_mut_obj_add_int(doc, root, MESSAGE_TYPE_KEY, MESSAGE_PLACE_SHIPS);
-    yyjson_mut_val *length_arr = yyjson_mut_obj_add_arr(doc, root, LENGTH_KEY);
+    BShip_MessageWriter writer = { .buffer = message->buffer };
+    MessageWriter_Char(&writer, '{');
+    MESSAGE_WRITER_KEY(&writer, MESSAGE_TYPE_KEY);
+    MessageWriter_Uint(&writer, MESSAGE_PLACE_SHIPS);
+    MessageWriter_Char(&writer, ',');
+    MESSAGE_WRITER_KEY(&writer, LENGTH_KEY);
+    MessageWriter_Char(&writer, '[');
     for (uint8_t i = 0; i < ship_count; i++)
     {
         uint8_t length = ship_lengths[i];
@@ -127,21 +327,45 @@ void BShip_Message_PlaceShips_Create(BShip_Message *message, uint8_t *ship_lengt
         {
             break;
         }
-        yyjson_mut_arr_add_int(doc, length_arr, length);
+        if (i > 0)
+        {
+            MessageWriter_Char(&writer, ',');
+        }
+        MessageWriter_Uint(&writer, length);
     }
+    MESSAGE_WRITER_LITERAL(&writer, "]}");
+    MessageWriter_Finish(&writer, message);
+}
 
-    size_t length = 0;
-    char *json = yyjson_mut_write(doc, 0, &length);
-    assert(length < BSHIP_MESSAGE_SIZE);
-
-    strncpy(message->buffer, json, length);
+static BShip_ErrorType Message_ShipsPlaced_ParseBinary(BShip_Message message, BShip_ShipArray *ships,
+    uint8_t ship_count)
+{
+    uint8_t *bytes = (uint8_t *)message.buffer;
+    if (message.length != BINARY_SHIPS_PLACED_HEADER_SIZE + (ship_count * BINARY_SHIP_SIZE)
+        || bytes[0] != MESSAGE_SHIPS_PLACED || bytes[1] != ship_count)
+    {
+        PRINT_ERROR_F("Invalid binary \"Ships Placed\" message received: <%u bytes>", message.length);
+        return ERROR_MESSAGE_SHIPS_PLACED_INVALID;
+    }
 
-    free(json);
-    yyjson_mut_doc_free(doc);
+    uint8_t *ship_bytes = &bytes[BINARY_SHIPS_PLACED_HEADER_SIZE];
+    for (ships->length = 0; ships->length < ship_count; ships->length++, ship_bytes += BINARY_SHIP_SIZE)
+    {
+        BShip_Ship ship = {
+            .row = ship_bytes[0],
+            .column = ship_bytes[1],
+            .length = ship_bytes[2],
+            .direction = (BShip_Direction)ship_bytes[3],
+        };
+        ships->buffer[ships->length] = ship;
+    }
+    return ERROR_SUCCESS;
 }
 
-BShip_ErrorType BShip_Message_ShipsPlaced_Parse(BShip_Message message, BShip_ShipArray *ships, uint8_t ship_count)
+BShip_ErrorType BShip_Message_ShipsPlaced_Parse(BShip_Arena *arena, BShip_Message message, BShip_ShipArray *ships,
+    uint8_t ship_count, BShip_MessageEncoding encoding)
 {
+    assert(arena != NULL);
     assert(message.buffer != NULL);
     assert(ships != NULL);
     assert(ships->buffer != NULL);
@@ -149,7 +373,13 @@ BShip_ErrorType BShip_Message_ShipsPlaced_Parse(BShip_Message message, BShip_Shi
     assert(ship_count >= BSHIP_SHIP_COUNT_MIN);
     assert(ship_count <= BSHIP_SHIP_COUNT_MAX);
 
-    yyjson_doc *doc = yyjson_read(message.buffer, strlen(message.buffer), 0);
+    if (encoding == MESSAGE_ENCODING_BINARY)
+    {
+        return Message_ShipsPlaced_ParseBinary(message, ships, ship_count);
+    }
+
+    BSHIP_ARENA_TEMP_BEGIN(arena);
+    yyjson_doc *doc = Message_Read(arena, message);
     if (doc == NULL) goto on_error;
 
     yyjson_val *root = yyjson_doc_get_root(doc);
@@ -192,20 +422,42 @@ BShip_ErrorType BShip_Message_ShipsPlaced_Parse(BShip_Message message, BShip_Shi
         ships->buffer[ships->length] = ship;
     }
 
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_SUCCESS;
 on_error:
     PRINT_ERROR_F("Invalid \"Ships Placed\" message received: <%s>", message.buffer);
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_MESSAGE_SHIPS_PLACED_INVALID;
 }
 
-BShip_ErrorType BShip_Message_ShotTaken_Parse(BShip_Message message, BShip_Shot *shot)
+static BShip_ErrorType Message_ShotTaken_ParseBinary(BShip_Message message, BShip_Shot *shot)
 {
+    uint8_t *bytes = (uint8_t *)message.buffer;
+    if (message.length != BINARY_SHOT_TAKEN_SIZE || bytes[0] != MESSAGE_SHOT_TAKEN
+        || bytes[1] >= BSHIP_BOARD_SIZE_MAX || bytes[2] >= BSHIP_BOARD_SIZE_MAX)
+    {
+        PRINT_ERROR_F("Invalid binary \"Shot Taken\" message received: <%u bytes>", message.length);
+        return ERROR_MESSAGE_SHOT_TAKEN_INVALID;
+    }
+    shot->row = bytes[1];
+    shot->column = bytes[2];
+    return ERROR_SUCCESS;
+}
+
+BShip_ErrorType BShip_Message_ShotTaken_Parse(BShip_Arena *arena, BShip_Message message, BShip_Shot *shot,
+    BShip_MessageEncoding encoding)
+{
+    assert(arena != NULL);
     assert(message.buffer != NULL);
     assert(shot != NULL);
 
-    yyjson_doc *doc = yyjson_read(message.buffer, strlen(message.buffer), 0);
+    if (encoding == MESSAGE_ENCODING_BINARY)
+    {
+        return Message_ShotTaken_ParseBinary(message, shot);
+    }
+
+    BSHIP_ARENA_TEMP_BEGIN(arena);
+    yyjson_doc *doc = Message_Read(arena, message);
     if (doc == NULL) goto on_error;
 
     yyjson_val *root = yyjson_doc_get_root(doc);
@@ -232,98 +484,109 @@ BShip_ErrorType BShip_Message_ShotTaken_Parse(BShip_Message message, BShip_Shot
         shot->column = column;
     }
 
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_SUCCESS;
 on_error:
     PRINT_ERROR_F("Invalid \"Shot Taken\" message received: <%s>", message.buffer);
-    yyjson_doc_free(doc);
+    BSHIP_ARENA_TEMP_END(arena);
     return ERROR_MESSAGE_SHOT_TAKEN_INVALID;
 }
 
-void BShip_Message_ShotResult_Create(BShip_Message *message, BShip_Shot shot1, BShip_Shot shot2,
+static void Message_Ship_WriteBinary(uint8_t *bytes, BShip_Ship *ship)
+{
+    if (ship == NULL)
+    {
+        memset(bytes, 0, BINARY_SHIP_SIZE);
+        return;
+    }
+    bytes[0] = ship->row;
+    bytes[1] = ship->column;
+    bytes[2] = ship->length;
+    bytes[3] = (uint8_t)ship->direction;
+}
+
+static void Message_ShotResult_CreateBinary(BShip_Message *message, BShip_Shot shot1, BShip_Shot shot2,
         BShip_Ship *ai1_ship_killed, BShip_Ship *ai2_ship_killed, bool next_shot)
+{
+    uint8_t *bytes = (uint8_t *)message->buffer;
+    bytes[0] = MESSAGE_SHOT_RESULT;
+    bytes[1] = (next_shot ? BINARY_SHOT_RESULT_NEXT_SHOT : 0)
+        | (ai1_ship_killed != NULL ? BINARY_SHOT_RESULT_AI1_SHIP : 0)
+        | (ai2_ship_killed != NULL ? BINARY_SHOT_RESULT_AI2_SHIP : 0);
+    bytes[2] = shot1.row;
+    bytes[3] = shot1.column;
+    bytes[4] = (uint8_t)shot1.value;
+    bytes[5] = shot2.row;
+    bytes[6] = shot2.column;
+    bytes[7] = (uint8_t)shot2.value;
+    Message_Ship_WriteBinary(&bytes[8], ai1_ship_killed);
+    Message_Ship_WriteBinary(&bytes[8 + BINARY_SHIP_SIZE], ai2_ship_killed);
+    message->length = BINARY_SHOT_RESULT_SIZE;
+}
+
+void BShip_Message_ShotResult_Create(BShip_Message *message, BShip_Shot shot1, BShip_Shot shot2,
+        BShip_Ship *ai1_ship_killed, BShip_Ship *ai2_ship_killed, bool next_shot, BShip_MessageEncoding encoding)
 {
     assert(message != NULL);
     assert(message->buffer != NULL);
-    memset(message->buffer, 0, BSHIP_MESSAGE_SIZE);
 
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    yyjson_mut_val *root = yyjson_mut_obj(doc);
-    yyjson_mut_doc_set_root(doc, root);
-
-    yyjson_mut_obj_add_int(doc, root, MESSAGE_TYPE_KEY, MESSAGE_SHOT_RESULT);
-
-    yyjson_mut_val *shots_arr = yyjson_mut_obj_add_arr(doc, root, SHOT_KEY);
-    yyjson_mut_val *ai1_shot_arr = yyjson_mut_arr_add_arr(doc, shots_arr);
-    yyjson_mut_arr_add_int(doc, ai1_shot_arr, shot1.row);
-    yyjson_mut_arr_add_int(doc, ai1_shot_arr, shot1.column);
-    yyjson_mut_arr_add_int(doc, ai1_shot_arr, shot1.value);
+    if (encoding == MESSAGE_ENCODING_BINARY)
+    {
+        Message_ShotResult_CreateBinary(message, shot1, shot2, ai1_ship_killed, ai2_ship_killed, next_shot);
+        return;
+    }
 
-    yyjson_mut_val *ai2_shot_arr = yyjson_mut_arr_add_arr(doc, shots_arr);
-    yyjson_mut_arr_add_int(doc, ai2_shot_arr, shot2.row);
-    yyjson_mut_arr_add_int(doc, ai2_shot_arr, shot2.column);
-    yyjson_mut_arr_add_int(doc, ai2_shot_arr, shot2.value);
+    BShip_MessageWriter writer = { .buffer = message->buffer };
+    MessageWriter_Char(&writer, '{');
+    MESSAGE_WRITER_KEY(&writer, MESSAGE_TYPE_KEY);
+    MessageWriter_Uint(&writer, MESSAGE_SHOT_RESULT);
+    MessageWriter_Char(&writer, ',');
+    MESSAGE_WRITER_KEY(&writer, SHOT_KEY);
+    MessageWriter_Char(&writer, '[');
+    MessageWriter_Shot(&writer, shot1);
+    MessageWriter_Char(&writer, ',');
+    MessageWriter_Shot(&writer, shot2);
+    MessageWriter_Char(&writer, ']');
 
     if (ai1_ship_killed != NULL || ai2_ship_killed != NULL)
     {
-        yyjson_mut_val *ships_arr = yyjson_mut_obj_add_arr(doc, root, SHIP_KEY);
-        if (ai1_ship_killed == NULL)
-        {
-            yyjson_mut_arr_add_null(doc, ships_arr);
-        }
-        else
-        {
-            yyjson_mut_val *ai1_ship_arr = yyjson_mut_arr_add_arr(doc, ships_arr);
-            yyjson_mut_arr_add_int(doc, ai1_ship_arr, ai1_ship_killed->row);
-            yyjson_mut_arr_add_int(doc, ai1_ship_arr, ai1_ship_killed->column);
-            yyjson_mut_arr_add_int(doc, ai1_ship_arr, ai1_ship_killed->length);
-            yyjson_mut_arr_add_int(doc, ai1_ship_arr, ai1_ship_killed->direction);
-        }
-        if (ai2_ship_killed == NULL)
-        {
-            yyjson_mut_arr_add_null(doc, ships_arr);
-        }
-        else
-        {
-            yyjson_mut_val *ai2_ship_arr = yyjson_mut_arr_add_arr(doc, ships_arr);
-            yyjson_mut_arr_add_int(doc, ai2_ship_arr, ai2_ship_killed->row);
-            yyjson_mut_arr_add_int(doc, ai2_ship_arr, ai2_ship_killed->column);
-            yyjson_mut_arr_add_int(doc, ai2_ship_arr, ai2_ship_killed->length);
-            yyjson_mut_arr_add_int(doc, ai2_ship_arr, ai2_ship_killed->direction);
-        }
+        MessageWriter_Char(&writer, ',');
+        MESSAGE_WRITER_KEY(&writer, SHIP_KEY);
+        MessageWriter_Char(&writer, '[');
+        MessageWriter_Ship(&writer, ai1_ship_killed);
+        MessageWriter_Char(&writer, ',');
+        MessageWriter_Ship(&writer, ai2_ship_killed);
+        MessageWriter_Char(&writer, ']');
     }
 
-    yyjson_mut_obj_add_bool(doc, root, NEXT_SHOT_KEY, next_shot);
-
-    size_t length = 0;
-    char *json = yyjson_mut_write(doc, 0, &length);
-    assert(length <= BSHIP_MESSAGE_SIZE);
-
-    strncpy(message->buffer, json, length);
-
-    free(json);
-    yyjson_mut_doc_free(doc);
+    MessageWriter_Char(&writer, ',');
+    MESSAGE_WRITER_KEY(&writer, NEXT_SHOT_KEY);
+    if (next_shot)
+    {
+        MESSAGE_WRITER_LITERAL(&writer, "true}");
+    }
+    else
+    {
+        MESSAGE_WRITER_LITERAL(&writer, "false}");
+    }
+    MessageWriter_Finish(&writer, message);
 }
 
-void BShip_Message_MatchOver_Create(BShip_Message *message)
+void BShip_Message_MatchOver_Create(BShip_Message *message, bool new_match)
 {
     assert(message != NULL);
     assert(message->buffer != NULL);
-    memset(message->buffer, 0, BSHIP_MESSAGE_SIZE);
 
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    yyjson_mut_val *root = yyjson_mut_obj(doc);
-    yyjson_mut_doc_set_root(doc, root);
-
-    yyjson_mut_obj_add_int(doc, root, MESSAGE_TYPE_KEY, MESSAGE_MATCH_OVER);
-
-    size_t length = 0;
-    char *json = yyjson_mut_write(doc, 0, &length);
-    assert(length <= BSHIP_MESSAGE_SIZE);
-
-    strncpy(message->buffer, json, length);
-
-    free(json);
-    yyjson_mut_doc_free(doc);
+    BShip_MessageWriter writer = { .buffer = message->buffer };
+    MessageWriter_Char(&writer, '{');
+    MESSAGE_WRITER_KEY(&writer, MESSAGE_TYPE_KEY);
+    MessageWriter_Uint(&writer, MESSAGE_MATCH_OVER);
+    if (new_match)
+    {
+        MessageWriter_Char(&writer, ',');
+        MESSAGE_WRITER_KEY(&writer, NEW_MATCH_KEY);
+        MessageWriter_Uint(&writer, NEW_MATCH_SUPPORTED);
+    }
+    MessageWriter_Char(&writer, '}');
+    MessageWriter_Finish(&writer, message);
 }
-
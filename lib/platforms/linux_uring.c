@@ -0,0 +1,730 @@
+/**
+ * @file linux_uring.c
+ * @authors Matthew Getgen
+ * @brief Battleships Platform-specific Linux Code, with AI messages going through io_uring
+ * @date 2026-06-03
+ *
+ * Everything except the reactor and the AI message I/O is the same as unix.c, so that file is pulled in as is.
+ *
+ * Where the epoll reactor pays for a poll() and a send() per message sent, and an epoll_wait() plus a recv() per
+ * message received, this one only queues up the sends and the reads (with a linked timeout instead of the poll),
+ * and hands all of them to the kernel in the one io_uring_enter() that also waits on the replies. The messages
+ * are read into buffers registered with the ring, which live in the reactor's own (arena) memory.
+ *
+ * This talks to the kernel with the raw io_uring syscalls, so liburing isn't needed.
+ */
+
+#define _GNU_SOURCE
+#define BSHIP_PLATFORM_URING
+#include "unix.c"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+// NOTE(mattg): a match sends at most a few messages in a row (shot result, place ships) before it waits on a reply.
+#define BSHIP_URING_SEND_BUFFER_COUNT 4
+#define BSHIP_URING_BUFFER_COUNT (1 + BSHIP_URING_SEND_BUFFER_COUNT)
+
+#define BSHIP_URING_OP_READ 0
+#define BSHIP_URING_OP_TIMEOUT 1
+#define BSHIP_URING_OP_CANCEL 2
+#define BSHIP_URING_OP_EXIT 3 // NOTE(mattg): a poll on the AI's pidfd.
+#define BSHIP_URING_OP_SEND 4 // NOTE(mattg): + the index of the send buffer.
+
+#define BSHIP_URING_USER_DATA(index, op) (((uint64_t)(index) << 8) | (uint64_t)(op))
+
+typedef struct {
+    BShip_AIConnection *ai_conn;
+    void *data;
+    struct __kernel_timespec timeout;
+    BShip_ErrorType send_error;
+    uint32_t send_sizes[BSHIP_URING_SEND_BUFFER_COUNT];
+    uint8_t sends_busy; // NOTE(mattg): one bit per send buffer, set until the kernel is done with it.
+    uint8_t send_next;
+    bool used;
+    bool debug;
+    bool expecting;
+    bool reading;
+    bool exiting; // NOTE(mattg): waiting on the AI's pidfd instead of its socket.
+    bool polling;
+    bool timed_out;
+    bool ready;
+} BShip_ReactorEntry;
+
+struct BShip_Reactor {
+    int32_t ring_desc;
+    uint32_t sq_entries;
+    uint32_t sq_tail; // NOTE(mattg): our copy of the tail, the kernel only sees it when we submit.
+    uint32_t sq_submitted;
+    uint32_t send_completions; // NOTE(mattg): how many completions the sends submitted next will post.
+    uint32_t *sq_head;
+    uint32_t *sq_kernel_tail;
+    uint32_t *sq_mask;
+    uint32_t *sq_array;
+    struct io_uring_sqe *sqes;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    uint8_t *buffers;
+    bool buffers_registered;
+    uint32_t length;
+    uint32_t capacity;
+    // NOTE(mattg): this must be the last element, the entries (and then the buffers) are stored right after it.
+    BShip_ReactorEntry entries[];
+};
+
+static inline uint8_t *Reactor_GetBuffer(BShip_Reactor *reactor, uint32_t index, uint32_t buffer)
+{
+    return &reactor->buffers[((index * BSHIP_URING_BUFFER_COUNT) + buffer) * BSHIP_FRAME_SIZE_MAX];
+}
+
+static void Reactor_ArmRead(BShip_Reactor *reactor, uint32_t index);
+
+// Hands every queued submission to the kernel, and waits until at least min_complete completions are in.
+static int Reactor_Enter(BShip_Reactor *reactor, uint32_t min_complete)
+{
+    uint32_t to_submit = reactor->sq_tail - reactor->sq_submitted;
+    if (to_submit == 0 && min_complete == 0)
+    {
+        return 0;
+    }
+    __atomic_store_n(reactor->sq_kernel_tail, reactor->sq_tail, __ATOMIC_RELEASE);
+    long rc = syscall(__NR_io_uring_enter, reactor->ring_desc, to_submit, min_complete,
+        min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (rc == -1)
+    {
+        return -1;
+    }
+    reactor->sq_submitted += (uint32_t)rc;
+    if (reactor->sq_submitted == reactor->sq_tail)
+    {
+        reactor->send_completions = 0;
+    }
+    return 0;
+}
+
+// Gets count submission queue entries in a row (so a linked timeout can't be split from its read).
+static struct io_uring_sqe *Reactor_GetSQE(BShip_Reactor *reactor, uint32_t count)
+{
+    uint32_t head = __atomic_load_n(reactor->sq_head, __ATOMIC_ACQUIRE);
+    if (reactor->sq_tail + count - head > reactor->sq_entries)
+    {
+        if (Reactor_Enter(reactor, 0) == -1)
+        {
+            PRINT_ERROR(strerror(errno));
+            return NULL;
+        }
+        head = __atomic_load_n(reactor->sq_head, __ATOMIC_ACQUIRE);
+        if (reactor->sq_tail + count - head > reactor->sq_entries)
+        {
+            PRINT_ERROR("Reactor submission queue is full!");
+            return NULL;
+        }
+    }
+    struct io_uring_sqe *first = NULL;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t index = reactor->sq_tail & *reactor->sq_mask;
+        struct io_uring_sqe *sqe = &reactor->sqes[index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        reactor->sq_array[index] = index;
+        reactor->sq_tail++;
+        if (first == NULL)
+        {
+            first = sqe;
+        }
+    }
+    return first;
+}
+
+static struct io_uring_sqe *Reactor_NextSQE(BShip_Reactor *reactor, struct io_uring_sqe *sqe)
+{
+    uint32_t index = (uint32_t)(sqe - reactor->sqes);
+    return &reactor->sqes[(index + 1) & *reactor->sq_mask];
+}
+
+static void Reactor_Reap(BShip_Reactor *reactor)
+{
+    uint32_t head = *reactor->cq_head;
+    uint32_t tail = __atomic_load_n(reactor->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        struct io_uring_cqe *cqe = &reactor->cqes[head & *reactor->cq_mask];
+        uint32_t index = (uint32_t)(cqe->user_data >> 8);
+        uint32_t op = (uint32_t)(cqe->user_data & 0xff);
+        if (index >= reactor->capacity)
+        {
+            continue;
+        }
+        BShip_ReactorEntry *entry = &reactor->entries[index];
+        if (op == BSHIP_URING_OP_READ)
+        {
+            BShip_AIConnection *ai_conn = entry->ai_conn;
+            entry->reading = false;
+            if (cqe->res > 0)
+            {
+                memcpy(&ai_conn->read_buffer[ai_conn->read_end], Reactor_GetBuffer(reactor, index, 0),
+                    (size_t)cqe->res);
+                ai_conn->read_end += (uint32_t)cqe->res;
+            }
+            else if (cqe->res == 0)
+            {
+                ai_conn->read_error = ERROR_RECEIVE_EMPTY_MESSAGE;
+            }
+            else if (cqe->res == -ECANCELED)
+            {
+                entry->timed_out = true;
+            }
+            else
+            {
+                PRINT_ERROR(strerror(-cqe->res));
+                ai_conn->read_error = ERROR_RECEIVE_FAILED;
+            }
+
+            if (AIConnection_HasMessage(ai_conn) || entry->timed_out)
+            {
+                entry->ready = true;
+            }
+            else if (entry->expecting)
+            {
+                // NOTE(mattg): only part of a message is in, keep reading until the rest is.
+                Reactor_ArmRead(reactor, index);
+            }
+        }
+        else if (op == BSHIP_URING_OP_EXIT)
+        {
+            entry->polling = false;
+            if (cqe->res == -ECANCELED)
+            {
+                entry->timed_out = true;
+            }
+            else if (cqe->res < 0)
+            {
+                // NOTE(mattg): reported as a timeout, so the AI gets killed instead of waited on.
+                PRINT_ERROR(strerror(-cqe->res));
+                entry->timed_out = true;
+            }
+            entry->ready = true;
+        }
+        else if (op >= BSHIP_URING_OP_SEND)
+        {
+            entry->sends_busy &= (uint8_t)~(1u << (op - BSHIP_URING_OP_SEND));
+            if (cqe->res == -ECANCELED)
+            {
+                PRINT_ERROR("Waiting to send a message to the AI timed out!");
+                entry->send_error = ERROR_SEND_TIMEOUT;
+            }
+            else if (cqe->res < 0)
+            {
+                PRINT_ERROR(strerror(-cqe->res));
+                entry->send_error = ERROR_SEND_FAILED;
+            }
+            else if ((uint32_t)cqe->res != entry->send_sizes[op - BSHIP_URING_OP_SEND])
+            {
+                PRINT_ERROR("Message was only partially sent to the AI!");
+                entry->send_error = ERROR_SEND_FAILED;
+            }
+        }
+        // NOTE(mattg): timeouts and cancels only tell us they ran, their read or send reports what happened.
+    }
+    __atomic_store_n(reactor->cq_head, head, __ATOMIC_RELEASE);
+}
+
+BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Message message, bool debug)
+{
+    assert(ai_conn != NULL);
+    assert(message.buffer != NULL);
+    BShip_Reactor *reactor = ai_conn->reactor;
+    if (reactor == NULL)
+    {
+        return AIConnection_SendSocket(ai_conn, message, debug);
+    }
+    uint32_t index = ai_conn->reactor_index;
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+
+    // NOTE(mattg): sends are only queued here, so a send that failed is reported on the next one.
+    if (entry->send_error != ERROR_SUCCESS)
+    {
+        BShip_ErrorType error = entry->send_error;
+        entry->send_error = ERROR_SUCCESS;
+        return error;
+    }
+
+    uint8_t buffer = entry->send_next;
+    while (entry->sends_busy & (1u << buffer))
+    {
+        // NOTE(mattg): every send buffer is still in use, which only happens with an AI that stopped reading.
+        if (Reactor_Enter(reactor, 1) == -1 && errno != EINTR)
+        {
+            PRINT_ERROR(strerror(errno));
+            return ERROR_SEND_FAILED;
+        }
+        Reactor_Reap(reactor);
+    }
+
+    struct io_uring_sqe *sqe = Reactor_GetSQE(reactor, debug ? 1 : 2);
+    if (sqe == NULL)
+    {
+        return ERROR_SEND_FAILED;
+    }
+    uint8_t *send_buffer = Reactor_GetBuffer(reactor, index, 1 + buffer);
+    entry->send_sizes[buffer] = AIConnection_WriteFrame(ai_conn, message, send_buffer);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = ai_conn->socket_desc;
+    sqe->addr = (uint64_t)(uintptr_t)send_buffer;
+    sqe->len = entry->send_sizes[buffer];
+    // NOTE(mattg): an AI that exited early must not take the controller down with a SIGPIPE.
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_SEND + buffer);
+    if (!debug)
+    {
+        sqe->flags |= IOSQE_IO_LINK;
+        struct io_uring_sqe *timeout = Reactor_NextSQE(reactor, sqe);
+        timeout->opcode = IORING_OP_LINK_TIMEOUT;
+        timeout->addr = (uint64_t)(uintptr_t)&entry->timeout;
+        timeout->len = 1;
+        timeout->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_TIMEOUT);
+    }
+    entry->sends_busy |= (uint8_t)(1u << buffer);
+    entry->send_next = (uint8_t)((buffer + 1) % BSHIP_URING_SEND_BUFFER_COUNT);
+    // NOTE(mattg): the linked timeout posts a completion of its own, even when the send beats it.
+    reactor->send_completions += debug ? 1 : 2;
+    return ERROR_SUCCESS;
+}
+
+BShip_ErrorType BShip_AIConnection_Read(BShip_AIConnection *ai_conn, BShip_Message *message)
+{
+    assert(ai_conn != NULL);
+    assert(message != NULL);
+    assert(message->buffer != NULL);
+    BShip_Reactor *reactor = ai_conn->reactor;
+    if (reactor == NULL)
+    {
+        return AIConnection_ReadSocket(ai_conn, message);
+    }
+    BShip_ReactorEntry *entry = &reactor->entries[ai_conn->reactor_index];
+    if (entry->send_error != ERROR_SUCCESS)
+    {
+        BShip_ErrorType error = entry->send_error;
+        entry->send_error = ERROR_SUCCESS;
+        return error;
+    }
+
+    return AIConnection_TakeMessage(ai_conn, message);
+}
+
+
+size_t BShip_Reactor_GetSize(uint32_t capacity)
+{
+    // NOTE(mattg): + 0xf to align the buffers.
+    return sizeof(BShip_Reactor) + (sizeof(BShip_ReactorEntry) * capacity) + 0xf
+        + ((size_t)capacity * BSHIP_URING_BUFFER_COUNT * BSHIP_FRAME_SIZE_MAX);
+}
+
+bool BShip_Reactor_Create(BShip_Reactor *reactor, uint32_t capacity)
+{
+    assert(reactor != NULL);
+    memset(reactor, 0, sizeof(BShip_Reactor));
+    memset(reactor->entries, 0, sizeof(BShip_ReactorEntry) * capacity);
+    reactor->ring_desc = -1;
+    reactor->capacity = capacity;
+    reactor->buffers = (uint8_t *)(((uintptr_t)&reactor->entries[capacity] + 0xf) & ~(uintptr_t)0xf);
+
+    // every entry can have a read, a send, and their timeouts queued at once, plus a cancel.
+    uint32_t ring_size = 8;
+    while (ring_size < capacity * 5)
+    {
+        ring_size += ring_size;
+    }
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    long ring_desc = syscall(__NR_io_uring_setup, ring_size, &params);
+    if (ring_desc == -1 && errno == EINVAL)
+    {
+        // NOTE(mattg): older kernels don't know the flag, it's only an optimization.
+        memset(&params, 0, sizeof(params));
+        ring_desc = syscall(__NR_io_uring_setup, ring_size, &params);
+    }
+    if (ring_desc == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+    reactor->ring_desc = (int32_t)ring_desc;
+
+    reactor->sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+    reactor->cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (reactor->cq_ring_size > reactor->sq_ring_size)
+        {
+            reactor->sq_ring_size = reactor->cq_ring_size;
+        }
+        reactor->cq_ring_size = reactor->sq_ring_size;
+    }
+    reactor->sq_ring = mmap(NULL, reactor->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        reactor->ring_desc, IORING_OFF_SQ_RING);
+    if (reactor->sq_ring == MAP_FAILED)
+    {
+        PRINT_ERROR(strerror(errno));
+        reactor->sq_ring = NULL;
+        BShip_Reactor_Close(reactor);
+        return false;
+    }
+    reactor->cq_ring = reactor->sq_ring;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        reactor->cq_ring = mmap(NULL, reactor->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            reactor->ring_desc, IORING_OFF_CQ_RING);
+        if (reactor->cq_ring == MAP_FAILED)
+        {
+            PRINT_ERROR(strerror(errno));
+            reactor->cq_ring = NULL;
+            BShip_Reactor_Close(reactor);
+            return false;
+        }
+    }
+    reactor->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    reactor->sqes = mmap(NULL, reactor->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        reactor->ring_desc, IORING_OFF_SQES);
+    if (reactor->sqes == MAP_FAILED)
+    {
+        PRINT_ERROR(strerror(errno));
+        reactor->sqes = NULL;
+        BShip_Reactor_Close(reactor);
+        return false;
+    }
+
+    uint8_t *sq_ring = reactor->sq_ring;
+    uint8_t *cq_ring = reactor->cq_ring;
+    reactor->sq_entries = params.sq_entries;
+    reactor->sq_head = (uint32_t *)(sq_ring + params.sq_off.head);
+    reactor->sq_kernel_tail = (uint32_t *)(sq_ring + params.sq_off.tail);
+    reactor->sq_mask = (uint32_t *)(sq_ring + params.sq_off.ring_mask);
+    reactor->sq_array = (uint32_t *)(sq_ring + params.sq_off.array);
+    reactor->sq_tail = *reactor->sq_kernel_tail;
+    reactor->sq_submitted = reactor->sq_tail;
+    reactor->cq_head = (uint32_t *)(cq_ring + params.cq_off.head);
+    reactor->cq_tail = (uint32_t *)(cq_ring + params.cq_off.tail);
+    reactor->cq_mask = (uint32_t *)(cq_ring + params.cq_off.ring_mask);
+    reactor->cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+    struct iovec buffers = {
+        .iov_base = reactor->buffers,
+        .iov_len = (size_t)capacity * BSHIP_URING_BUFFER_COUNT * BSHIP_FRAME_SIZE_MAX,
+    };
+    // NOTE(mattg): registering can fail on a low RLIMIT_MEMLOCK, reads then just go through plain buffers.
+    reactor->buffers_registered = capacity > 0 &&
+        syscall(__NR_io_uring_register, reactor->ring_desc, IORING_REGISTER_BUFFERS, &buffers, 1) == 0;
+    return true;
+}
+
+void BShip_Reactor_Close(BShip_Reactor *reactor)
+{
+    if (reactor == NULL)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < reactor->capacity; i++)
+    {
+        if (reactor->entries[i].used)
+        {
+            reactor->entries[i].ai_conn->reactor = NULL;
+            reactor->entries[i].used = false;
+        }
+    }
+    if (reactor->sqes != NULL)
+    {
+        munmap(reactor->sqes, reactor->sqes_size);
+        reactor->sqes = NULL;
+    }
+    if (reactor->cq_ring != NULL && reactor->cq_ring != reactor->sq_ring)
+    {
+        munmap(reactor->cq_ring, reactor->cq_ring_size);
+    }
+    reactor->cq_ring = NULL;
+    if (reactor->sq_ring != NULL)
+    {
+        munmap(reactor->sq_ring, reactor->sq_ring_size);
+        reactor->sq_ring = NULL;
+    }
+    if (reactor->ring_desc > 2) // NOTE(mattg): -1 == io_uring_setup() error, 0 == stdin, 1 == stdout, 2 == stderr
+    {
+        close(reactor->ring_desc);
+    }
+    reactor->ring_desc = -1;
+    reactor->length = 0;
+}
+
+bool BShip_Reactor_Add(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, void *data)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    // NOTE(mattg): entries never move, the kernel may still be using their buffers.
+    uint32_t index = 0;
+    while (index < reactor->capacity && reactor->entries[index].used)
+    {
+        index++;
+    }
+    if (index >= reactor->capacity)
+    {
+        PRINT_ERROR("Reactor is full!");
+        return false;
+    }
+    reactor->entries[index] = (BShip_ReactorEntry){
+        .ai_conn = ai_conn,
+        .data = data,
+        .timeout = {
+            .tv_sec = BSHIP_TIMEOUT_SECONDS,
+            .tv_nsec = BSHIP_TIMEOUT_MILLISECONDS * 1000000L,
+        },
+        .send_error = ERROR_SUCCESS,
+        .used = true,
+    };
+    ai_conn->reactor = reactor;
+    ai_conn->reactor_index = index;
+    reactor->length++;
+    return true;
+}
+
+static void Reactor_Cancel(BShip_Reactor *reactor, uint32_t index, uint32_t op)
+{
+    struct io_uring_sqe *sqe = Reactor_GetSQE(reactor, 1);
+    if (sqe != NULL)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = BSHIP_URING_USER_DATA(index, op);
+        sqe->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_CANCEL);
+    }
+}
+
+// Stops the entry's read and exit poll, and waits until the kernel is done with all of its submissions.
+static void Reactor_Drain(BShip_Reactor *reactor, uint32_t index)
+{
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+    entry->expecting = false;
+
+    Reactor_Reap(reactor);
+    if (entry->reading)
+    {
+        Reactor_Cancel(reactor, index, BSHIP_URING_OP_READ);
+    }
+    if (entry->polling)
+    {
+        Reactor_Cancel(reactor, index, BSHIP_URING_OP_EXIT);
+    }
+    // NOTE(mattg): the queued sends (like match over) still have to go out, and the buffers can't be reused
+    // until the kernel is done with them.
+    while (entry->reading || entry->polling || entry->sends_busy != 0)
+    {
+        if (Reactor_Enter(reactor, 1) == -1 && errno != EINTR)
+        {
+            PRINT_ERROR(strerror(errno));
+            break;
+        }
+        Reactor_Reap(reactor);
+    }
+}
+
+void BShip_Reactor_Remove(BShip_Reactor *reactor, BShip_AIConnection *ai_conn)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    uint32_t index = ai_conn->reactor_index;
+    if (ai_conn->reactor != reactor || index >= reactor->capacity || reactor->entries[index].ai_conn != ai_conn)
+    {
+        return;
+    }
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+    Reactor_Drain(reactor, index);
+    entry->used = false;
+    entry->ai_conn = NULL;
+    ai_conn->reactor = NULL;
+    reactor->length--;
+}
+
+static void Reactor_ArmRead(BShip_Reactor *reactor, uint32_t index)
+{
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+    BShip_AIConnection *ai_conn = entry->ai_conn;
+    uint32_t space = AIConnection_GetReadSpace(ai_conn);
+    struct io_uring_sqe *sqe = Reactor_GetSQE(reactor, entry->debug ? 1 : 2);
+    if (sqe == NULL || space == 0)
+    {
+        ai_conn->read_error = ERROR_RECEIVE_FAILED;
+        entry->ready = true;
+        return;
+    }
+    uint8_t *read_buffer = Reactor_GetBuffer(reactor, index, 0);
+    sqe->opcode = reactor->buffers_registered ? IORING_OP_READ_FIXED : IORING_OP_RECV;
+    sqe->fd = ai_conn->socket_desc;
+    sqe->addr = (uint64_t)(uintptr_t)read_buffer;
+    sqe->len = space < BSHIP_FRAME_SIZE_MAX ? space : BSHIP_FRAME_SIZE_MAX;
+    sqe->buf_index = 0;
+    sqe->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_READ);
+    if (!entry->debug)
+    {
+        // NOTE(mattg): this takes the place of the poll() timeout, the read is cancelled if it takes too long.
+        sqe->flags |= IOSQE_IO_LINK;
+        struct io_uring_sqe *timeout = Reactor_NextSQE(reactor, sqe);
+        timeout->opcode = IORING_OP_LINK_TIMEOUT;
+        timeout->addr = (uint64_t)(uintptr_t)&entry->timeout;
+        timeout->len = 1;
+        timeout->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_TIMEOUT);
+    }
+    entry->reading = true;
+}
+
+void BShip_Reactor_Expect(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    uint32_t index = ai_conn->reactor_index;
+    assert(index < reactor->capacity);
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+    assert(entry->ai_conn == ai_conn);
+    assert(!entry->exiting);
+    entry->expecting = true;
+    entry->debug = debug;
+    entry->timed_out = false;
+    entry->ready = false;
+    // NOTE(mattg): an AI can send more than one message at once, the ones already read don't have to be waited on.
+    if (AIConnection_HasMessage(ai_conn))
+    {
+        entry->ready = true;
+        return;
+    }
+    if (!entry->reading)
+    {
+        Reactor_ArmRead(reactor, index);
+    }
+}
+
+bool BShip_Reactor_ExpectExit(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    uint32_t index = ai_conn->reactor_index;
+    assert(index < reactor->capacity);
+    BShip_ReactorEntry *entry = &reactor->entries[index];
+    assert(entry->ai_conn == ai_conn);
+    if (ai_conn->pid_desc == -1)
+    {
+        return false;
+    }
+    // NOTE(mattg): the socket is about to be closed, so nothing can be reading from (or sending to) it anymore.
+    Reactor_Drain(reactor, index);
+    struct io_uring_sqe *sqe = Reactor_GetSQE(reactor, debug ? 1 : 2);
+    if (sqe == NULL)
+    {
+        return false;
+    }
+    uint32_t poll_events = POLLIN;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    poll_events = (poll_events << 16) | (poll_events >> 16); // NOTE(mattg): the kernel swaps the halves back.
+#endif
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = ai_conn->pid_desc;
+    sqe->poll32_events = poll_events;
+    sqe->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_EXIT);
+    if (!debug)
+    {
+        sqe->flags |= IOSQE_IO_LINK;
+        struct io_uring_sqe *timeout = Reactor_NextSQE(reactor, sqe);
+        timeout->opcode = IORING_OP_LINK_TIMEOUT;
+        timeout->addr = (uint64_t)(uintptr_t)&entry->timeout;
+        timeout->len = 1;
+        timeout->user_data = BSHIP_URING_USER_DATA(index, BSHIP_URING_OP_TIMEOUT);
+    }
+    entry->exiting = true;
+    entry->polling = true;
+    entry->expecting = true;
+    entry->debug = debug;
+    entry->timed_out = false;
+    entry->ready = false;
+    return true;
+}
+
+int32_t BShip_Reactor_Wait(BShip_Reactor *reactor, BShip_ReactorEvent *events, uint32_t capacity)
+{
+    assert(reactor != NULL);
+    assert(events != NULL);
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        Reactor_Reap(reactor);
+        uint32_t count = 0;
+        bool expecting = false;
+        for (uint32_t i = 0; i < reactor->capacity && count < capacity; i++)
+        {
+            BShip_ReactorEntry *entry = &reactor->entries[i];
+            if (!entry->used || !entry->expecting)
+            {
+                continue;
+            }
+            if (!entry->ready)
+            {
+                expecting = true;
+                continue;
+            }
+            entry->expecting = false;
+            entry->ready = false;
+            BShip_ReactorEventType type = BSHIP_REACTOR_TIMEOUT;
+            if (entry->exiting)
+            {
+                type = entry->timed_out ? BSHIP_REACTOR_TIMEOUT : BSHIP_REACTOR_EXITED;
+            }
+            else if (AIConnection_HasMessage(entry->ai_conn))
+            {
+                type = BSHIP_REACTOR_READABLE;
+            }
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = type,
+            };
+        }
+        if (count > 0)
+        {
+            return (int32_t)count;
+        }
+        if (!expecting)
+        {
+            // NOTE(mattg): nothing to wait on, but the queued sends still have to go out.
+            if (Reactor_Enter(reactor, 0) == -1 && errno != EINTR)
+            {
+                PRINT_ERROR(strerror(errno));
+                return -1;
+            }
+            return 0;
+        }
+
+        // NOTE(mattg): the sends usually complete while being submitted, so wait on one more than those.
+        if (Reactor_Enter(reactor, reactor->send_completions + 1) == -1)
+        {
+            if (errno == EINTR)
+            {
+                return 0;
+            }
+            else if (errno == EAGAIN || errno == EBUSY)
+            {
+                continue;
+            }
+            PRINT_ERROR(strerror(errno));
+            return -1;
+        }
+    }
+}
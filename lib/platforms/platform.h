@@ -19,14 +19,70 @@ bool BShip_PathIsExecutable(char *path);
 
 bool BShip_PathIsDirectory(char *path);
 
+double BShip_Time_GetSeconds(void);
+
+uint32_t BShip_Processor_GetCount(void);
+
+typedef struct BShip_Thread BShip_Thread;
+
+typedef struct BShip_Mutex BShip_Mutex;
+
+typedef void (*BShip_ThreadProc)(void *data);
+
+size_t BShip_Thread_GetSize(void);
+
+size_t BShip_Mutex_GetSize(void);
+
+bool BShip_Thread_Start(BShip_Thread *thread, BShip_ThreadProc proc, void *data);
+
+void BShip_Thread_Join(BShip_Thread *thread);
+
+bool BShip_Mutex_Initialize(BShip_Mutex *mutex);
+
+void BShip_Mutex_Destroy(BShip_Mutex *mutex);
+
+void BShip_Mutex_Lock(BShip_Mutex *mutex);
+
+void BShip_Mutex_Unlock(BShip_Mutex *mutex);
+
+// A shared library loaded into the controller, which is how in-process players (plugins) are loaded.
+typedef struct BShip_Library BShip_Library;
+
+size_t BShip_Library_GetSize(void);
+
+bool BShip_Library_Open(BShip_Library *library, char *path);
+
+void *BShip_Library_GetSymbol(BShip_Library *library, char *name);
+
+void BShip_Library_Close(BShip_Library *library);
+
 typedef struct BShip_Connection BShip_Connection;
 
 typedef struct BShip_AIConnection BShip_AIConnection;
 
+// NOTE(mattg): an AI started once and initialized, which forks a fresh copy of itself for each match.
+typedef struct BShip_AIZygote BShip_AIZygote;
+
+typedef struct BShip_Reactor BShip_Reactor;
+
+typedef enum {
+    BSHIP_REACTOR_READABLE,
+    BSHIP_REACTOR_TIMEOUT,
+    BSHIP_REACTOR_EXITED,
+} BShip_ReactorEventType;
+
+typedef struct {
+    BShip_AIConnection *ai_conn;
+    void *data;
+    BShip_ReactorEventType type;
+} BShip_ReactorEvent;
+
 size_t BShip_Connection_GetSize(void);
 
 size_t BShip_AIConnection_GetSize(void);
 
+size_t BShip_AIZygote_GetSize(void);
+
 bool BShip_Connection_Create(BShip_Connection *conn, char *socket_path);
 
 void BShip_Connection_Close(BShip_Connection *conn);
@@ -38,13 +94,60 @@ bool BShip_AIConnection_WaitProcess(BShip_AIConnection *ai_conn, bool debug);
 
 void BShip_AIConnection_KillProcess(BShip_AIConnection *ai_conn);
 
+// Gets what the AI's process used, once BShip_AIConnection_WaitProcess or _KillProcess collected it. Returns false
+// (and zeroes usage) when it wasn't, like for an AI forked by a zygote, which isn't our child.
+bool BShip_AIConnection_GetUsage(BShip_AIConnection *ai_conn, BShip_AIUsage *usage);
+
+// Gets what the AI's process used so far while it's still running, which also works for an AI forked by a zygote.
+// Returns false (and zeroes usage) when it can't be read, like once it exited, or off Linux.
+bool BShip_AIConnection_SampleUsage(BShip_AIConnection *ai_conn, BShip_AIUsage *usage);
+
+// Starts the AI as a zygote, and waits for it to say it's ready to fork. It can have up to copy_capacity copies
+// running at once.
+BShip_ErrorType BShip_AIZygote_Start(BShip_AIZygote *zygote, char *ai_path, char *ai_dir, uint32_t copy_capacity,
+    bool debug);
+
+// Has the zygote fork a copy of its AI, connected through a socket pair, so there is nothing to accept.
+BShip_ErrorType BShip_AIConnection_StartFromZygote(BShip_AIConnection *ai_conn, BShip_AIZygote *zygote, bool debug);
+
+void BShip_AIZygote_Stop(BShip_AIZygote *zygote, bool debug);
+
 BShip_ErrorType BShip_AIConnection_Accept(BShip_AIConnection *ai_conn, BShip_Connection *conn, bool debug);
 
 BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Message message, bool debug);
 
 BShip_ErrorType BShip_AIConnection_Receive(BShip_AIConnection *ai_conn, BShip_Message *message, bool debug);
 
+// NOTE(mattg): receives without waiting, use this once the reactor says a message is in.
+BShip_ErrorType BShip_AIConnection_Read(BShip_AIConnection *ai_conn, BShip_Message *message);
+
+// NOTE(mattg): switches between fixed BSHIP_MESSAGE_SIZE messages and length prefixed frames (a 2 byte big endian
+// length, then the message without padding), which an AI can ask for in its hello.
+void BShip_AIConnection_SetFramed(BShip_AIConnection *ai_conn, bool framed);
+
 void BShip_AIConnection_Close(BShip_AIConnection *conn);
 
+// The reactor waits on many AI connections at once, so one thread can serve many matches. Every expected
+// reply gets the same timeout a single BShip_AIConnection_Receive would, and shows up as a timeout event
+// if it doesn't come in time.
+size_t BShip_Reactor_GetSize(uint32_t capacity);
+
+bool BShip_Reactor_Create(BShip_Reactor *reactor, uint32_t capacity);
+
+void BShip_Reactor_Close(BShip_Reactor *reactor);
+
+bool BShip_Reactor_Add(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, void *data);
+
+void BShip_Reactor_Remove(BShip_Reactor *reactor, BShip_AIConnection *ai_conn);
+
+void BShip_Reactor_Expect(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug);
+
+// Waits on the AI's process to exit instead of on its socket, which can be closed once this returns true. The exit
+// shows up as an exited event, or as a timeout event if it doesn't come in time. Returns false when the AI has no
+// pidfd, BShip_AIConnection_WaitProcess has to wait on it then.
+bool BShip_Reactor_ExpectExit(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug);
+
+int32_t BShip_Reactor_Wait(BShip_Reactor *reactor, BShip_ReactorEvent *events, uint32_t capacity);
+
 
 #endif // BSHIP_PLATFORM_H
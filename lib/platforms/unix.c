@@ -7,16 +7,36 @@
  * Unix Domain Socket Programming from [Beej's Guide](https://beej.us/guide/bgipc/html/split/unixsock.html)
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // NOTE(mattg): for clone(), which starts the AIs.
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#define _DARWIN_C_SOURCE // NOTE(mattg): for wait4(), which _POSIX_C_SOURCE hides.
+#endif
 #define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <poll.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -28,16 +48,97 @@
 
 #define BSHIP_TIMEOUT_SECONDS 0
 #define BSHIP_TIMEOUT_MILLISECONDS 500
+// NOTE(mattg): AIs started on a socket pair find their end of it at this fd, passed as "fd:3" instead of a path.
+#define BSHIP_SOCKET_PAIR_FD 3
+#define BSHIP_SOCKET_PAIR_ARG "fd:3"
+#define BSHIP_FRAME_HEADER_SIZE 2
+#define BSHIP_FRAME_SIZE_MAX (BSHIP_FRAME_HEADER_SIZE + BSHIP_MESSAGE_SIZE)
+// NOTE(mattg): room for a few messages, since an AI can send more than one before it is asked for them.
+#define BSHIP_READ_BUFFER_SIZE (BSHIP_FRAME_SIZE_MAX * 4)
+#define BSHIP_HOME_ENV_START "HOME="
+#define BSHIP_HOME_ENV_SIZE_MAX (sizeof(BSHIP_HOME_ENV_START) + PATH_MAX)
+// NOTE(mattg): the AI's process only runs AIProcess_Exec on this before it is replaced by the AI.
+#define BSHIP_SPAWN_STACK_SIZE (64 * 1024)
+// NOTE(mattg): an AI started as a zygote finds this in its environment, and its fd 3 is then the zygote's control
+// socket instead of a match. It answers with BSHIP_ZYGOTE_READY once it is initialized, and then with the process id
+// of the copy it forked for each BSHIP_ZYGOTE_FORK, which comes with the copy's end of its socket pair (SCM_RIGHTS).
+// Each copy has to be in its own process group, and reaped by the zygote as soon as it exits.
+#define BSHIP_ZYGOTE_ENV "BSHIP_ZYGOTE=1"
+#define BSHIP_ZYGOTE_READY 0
+#define BSHIP_ZYGOTE_FORK 'f'
+#define BSHIP_AI_PROCESS_LIMIT 20
+// NOTE(mattg): RLIMIT_NPROC counts every process (thread, really) of the user, not just the AI's own, so a zygote
+// capped at BSHIP_AI_PROCESS_LIMIT couldn't fork at all for a user already running that many. It's capped at what
+// the user had when it was started, plus BSHIP_AI_PROCESS_LIMIT for itself and one for each copy it can have running
+// at once, instead. Each copy lowers its own to BSHIP_AI_PROCESS_LIMIT before it runs anything else, and since that's
+// up to the AI, the controller lowers it again as soon as it's told the pid.
+// Only Linux can count them (and limit another process), so there aren't zygotes elsewhere.
+#if defined(__linux__) && defined(SYS_pidfd_open) && defined(SYS_pidfd_send_signal)
+#define BSHIP_ZYGOTE_SUPPORTED
+#endif
 
 struct BShip_Connection {
     struct sockaddr_un socket_address;
     int32_t socket_desc;
+    bool socket_pair;
 };
 
 struct BShip_AIConnection {
     int32_t socket_desc;
     int32_t exit_status;
     pid_t process_id;
+    // NOTE(mattg): a pidfd, readable once the AI exits. For an AI forked by a zygote, it's also what keeps its pid from
+    // going to another process, since the zygote reaps it. -1 without pidfds (not Linux, or before 5.3).
+    int32_t pid_desc;
+    BShip_Reactor *reactor;
+    uint32_t reactor_index;
+    BShip_ErrorType read_error; // NOTE(mattg): the AI closed its end (or broke it), handed out after the messages.
+    uint32_t read_start;
+    uint32_t read_end;
+    bool framed;
+    bool forked; // NOTE(mattg): forked by a zygote, so it's the zygote's child and can't be waited on with waitpid.
+    bool usage_measured;
+    struct rusage usage; // NOTE(mattg): filled in by wait4() once the AI exited.
+    uint8_t read_buffer[BSHIP_READ_BUFFER_SIZE];
+};
+
+struct BShip_AIZygote {
+    BShip_AIConnection control;
+};
+
+// NOTE(mattg): linux_uring.c builds on top of this file, and brings its own reactor.
+#ifndef BSHIP_PLATFORM_URING
+typedef struct {
+    BShip_AIConnection *ai_conn;
+    void *data;
+    double deadline; // NOTE(mattg): 0 - not expecting a message, < 0 - expecting one without a timeout (debug)
+    bool muted;
+    bool exiting; // NOTE(mattg): waiting on the AI's pidfd instead of its socket.
+} BShip_ReactorEntry;
+
+struct BShip_Reactor {
+#ifdef __linux__
+    int32_t epoll_desc;
+#endif
+    uint32_t length;
+    uint32_t capacity;
+    // NOTE(mattg): this must be the last element, the entries are stored right after the struct.
+    BShip_ReactorEntry entries[];
+};
+#endif
+
+struct BShip_Thread {
+    pthread_t handle;
+    BShip_ThreadProc proc;
+    void *data;
+};
+
+struct BShip_Mutex {
+    pthread_mutex_t handle;
+};
+
+struct BShip_Library {
+    void *handle;
 };
 
 void *BShip_Allocate(size_t size)
@@ -80,6 +181,141 @@ bool BShip_PathIsDirectory(char *path)
     return (S_ISDIR(statbuf.st_mode));
 }
 
+double BShip_Time_GetSeconds(void)
+{
+    struct timespec time = {0};
+    if (clock_gettime(CLOCK_MONOTONIC, &time) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return 0.0;
+    }
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1e9);
+}
+
+uint32_t BShip_Processor_GetCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1)
+    {
+        return 1;
+    }
+    return (uint32_t)count;
+}
+
+size_t BShip_Thread_GetSize(void)
+{
+    return (size_t)sizeof(BShip_Thread);
+}
+
+size_t BShip_Mutex_GetSize(void)
+{
+    return (size_t)sizeof(BShip_Mutex);
+}
+
+static void *BShip_Thread_Entry(void *data)
+{
+    BShip_Thread *thread = data;
+    thread->proc(thread->data);
+    return NULL;
+}
+
+bool BShip_Thread_Start(BShip_Thread *thread, BShip_ThreadProc proc, void *data)
+{
+    assert(thread != NULL);
+    assert(proc != NULL);
+    thread->proc = proc;
+    thread->data = data;
+    int rc = pthread_create(&thread->handle, NULL, BShip_Thread_Entry, thread);
+    if (rc != 0)
+    {
+        PRINT_ERROR(strerror(rc));
+        return false;
+    }
+    return true;
+}
+
+void BShip_Thread_Join(BShip_Thread *thread)
+{
+    assert(thread != NULL);
+    int rc = pthread_join(thread->handle, NULL);
+    if (rc != 0)
+    {
+        PRINT_ERROR(strerror(rc));
+    }
+}
+
+bool BShip_Mutex_Initialize(BShip_Mutex *mutex)
+{
+    assert(mutex != NULL);
+    int rc = pthread_mutex_init(&mutex->handle, NULL);
+    if (rc != 0)
+    {
+        PRINT_ERROR(strerror(rc));
+        return false;
+    }
+    return true;
+}
+
+void BShip_Mutex_Destroy(BShip_Mutex *mutex)
+{
+    assert(mutex != NULL);
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+void BShip_Mutex_Lock(BShip_Mutex *mutex)
+{
+    assert(mutex != NULL);
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void BShip_Mutex_Unlock(BShip_Mutex *mutex)
+{
+    assert(mutex != NULL);
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+size_t BShip_Library_GetSize(void)
+{
+    return (size_t)sizeof(BShip_Library);
+}
+
+bool BShip_Library_Open(BShip_Library *library, char *path)
+{
+    assert(library != NULL);
+    assert(path != NULL);
+    // NOTE(mattg): RTLD_LOCAL, so two plugins can export the same symbols without one replacing the other.
+    library->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (library->handle == NULL)
+    {
+        PRINT_ERROR(dlerror());
+        return false;
+    }
+    return true;
+}
+
+void *BShip_Library_GetSymbol(BShip_Library *library, char *name)
+{
+    assert(library != NULL);
+    assert(library->handle != NULL);
+    assert(name != NULL);
+    void *symbol = dlsym(library->handle, name);
+    if (symbol == NULL)
+    {
+        PRINT_ERROR(dlerror());
+    }
+    return symbol;
+}
+
+void BShip_Library_Close(BShip_Library *library)
+{
+    assert(library != NULL);
+    if (library->handle != NULL)
+    {
+        dlclose(library->handle);
+        library->handle = NULL;
+    }
+}
+
 size_t BShip_Connection_GetSize(void)
 {
     return (size_t)sizeof(BShip_Connection);
@@ -90,31 +326,33 @@ size_t BShip_AIConnection_GetSize(void)
     return (size_t)sizeof(BShip_AIConnection);
 }
 
+size_t BShip_AIZygote_GetSize(void)
+{
+    return (size_t)sizeof(BShip_AIZygote);
+}
+
 bool BShip_Connection_Create(BShip_Connection *conn, char *socket_path)
 {
     assert(conn != NULL);
-    assert(socket_path != NULL);
 
     socklen_t socket_address_length = sizeof(conn->socket_address.sun_path);
+    memset(conn, 0, sizeof(BShip_Connection));
 
-    conn->socket_address.sun_family = AF_UNIX;
-    memset(&conn->socket_address.sun_path, 0, socket_address_length);
-
-    conn->socket_desc = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (conn->socket_desc == -1)
+    if (socket_path == NULL)
     {
-        PRINT_ERROR(strerror(errno));
-        goto on_error;
+        // NOTE(mattg): no named socket, every AI gets its own socket pair when it is started.
+        conn->socket_desc = -1;
+        conn->socket_pair = true;
+        return true;
     }
 
-    int flags = fcntl(conn->socket_desc, F_GETFD);
-    if (flags == -1)
-    {
-        PRINT_ERROR(strerror(errno));
-        goto on_error;
-    }
+    conn->socket_address.sun_family = AF_UNIX;
+    memset(&conn->socket_address.sun_path, 0, socket_address_length);
 
-    if (fcntl(conn->socket_desc, F_SETFD, flags | FD_CLOEXEC) == -1)
+    // NOTE(mattg): FD_CLOEXEC from the start, a later fcntl() would leave a window for an AI another worker thread
+    // starts to inherit it.
+    conn->socket_desc = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn->socket_desc == -1)
     {
         PRINT_ERROR(strerror(errno));
         goto on_error;
@@ -137,6 +375,14 @@ bool BShip_Connection_Create(BShip_Connection *conn, char *socket_path)
         goto on_error;
     }
 
+    // NOTE(mattg): listen before any AI is started, otherwise a fast AI can try to connect before
+    // the socket is accepting connections and get refused.
+    if (listen(conn->socket_desc, 2) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        goto on_error;
+    }
+
     return true;
 on_error:
     BShip_Connection_Close(conn);
@@ -153,218 +399,791 @@ void BShip_Connection_Close(BShip_Connection *conn)
     {
         close(conn->socket_desc);
     }
-    unlink(conn->socket_address.sun_path);
+    if (conn->socket_address.sun_path[0] != '\0')
+    {
+        unlink(conn->socket_address.sun_path);
+    }
     memset(conn, 0, sizeof(BShip_Connection));
 }
 
-BShip_ErrorType BShip_AIConnection_StartProcess(BShip_AIConnection *ai_conn, char *socket_path,
-    char *ai_path, char *ai_dir)
+typedef struct {
+    char *ai_path;
+    char *ai_dir;
+    char **argv;
+    char **envp;
+    int pair_desc;
+    rlim_t process_limit;
+    sigset_t signal_mask;
+    volatile int error; // NOTE(mattg): the errno of whatever failed in the child, when it shares our memory.
+} BShip_AIProcessArgs;
+
+// Runs in the AI's process, until execve replaces it with the AI. On Linux this shares the controller's memory,
+// so it may only make async-signal-safe calls: no allocating, no printing, and no returning.
+static int AIProcess_Exec(void *data)
 {
-    assert(ai_conn != NULL);
-    assert(ai_path != NULL);
-    assert (socket_path != NULL);
+    BShip_AIProcessArgs *args = data;
 
-    if (!BShip_PathIsExecutable(ai_path))
+    // move the AI's end of the socket pair to the fd it expects, dup2() clears FD_CLOEXEC on the copy.
+    if (args->pair_desc != -1)
     {
-        PRINT_ERROR_F("AI file %s is not an executable!", ai_path);
-        return ERROR_AI_PATH_ISSUE;
+        if (args->pair_desc == BSHIP_SOCKET_PAIR_FD)
+        {
+            if (fcntl(args->pair_desc, F_SETFD, 0) == -1) goto on_error;
+        }
+        else if (dup2(args->pair_desc, BSHIP_SOCKET_PAIR_FD) == -1) goto on_error;
     }
 
-    if (!BShip_PathIsDirectory(ai_dir))
+    // allow CTRL-C to kill the child process, and don't keep any of the controller's handlers around.
+    for (int signal_number = 1; signal_number < NSIG; signal_number++)
     {
-        PRINT_ERROR_F("AI directory %s is not a directory!", ai_dir);
-        return ERROR_AI_PATH_ISSUE;
+        struct sigaction action;
+        if (sigaction(signal_number, NULL, &action) == 0 && action.sa_handler != SIG_IGN)
+        {
+            action.sa_handler = SIG_DFL;
+            action.sa_flags = 0;
+            sigaction(signal_number, &action, NULL);
+        }
     }
 
-    ai_conn->process_id = fork();
+    // PROCESS RESTRICTION - security surrounding child processes in UNIX/POSIX systems.
+    // 1. Manage process user and group permissions.
+    if (setpgid(0, 0) == -1) goto on_error;
 
-    if (ai_conn->process_id == 0)
-    {
-        // child process
- 
-        // allow CTRL-C to kill the child process.
-        if (signal(SIGINT, SIG_DFL) == SIG_ERR)
+    // 2. Set system resource limits.
+    rlim_t file_size_limit = 10 * 1024 * 1024;
+    typedef struct {
+        int resource;
+        rlim_t soft_limit;
+        rlim_t hard_limit;
+    } ResourceType;
+    ResourceType resources[] = {
         {
-            PRINT_ERROR(strerror(errno));
-            goto on_error;
-        }
-
-        // PROCESS RESTRICTION - security surrounding child processes in UNIX/POSIX systems.
-        // 1. Manage process user and group permissions.
-        if (setpgid(0, 0) == -1)
+            // # processes
+            .resource = RLIMIT_NPROC,
+            .soft_limit = args->process_limit,
+            .hard_limit = args->process_limit,
+        },
         {
-            PRINT_ERROR(strerror(errno));
-            goto on_error;
-        }
-
-        // 2. Set system resource limits.  
-        rlim_t file_size_limit = 10 * 1024 * 1024;
-        typedef struct {
-            int resource;
-            rlim_t soft_limit;
-            rlim_t hard_limit;
-        } ResourceType;
-        ResourceType resources[] = {
-            {
-                // # processes
-                .resource = RLIMIT_NPROC,
-                .soft_limit = 20,
-                .hard_limit = 20,
-            },
-            {
-                // # files open
-                .resource = RLIMIT_NOFILE,
-                .soft_limit = 64,
-                .hard_limit = 64,
-            },
-            {
-                // max file size
-                .resource = RLIMIT_FSIZE,
-                .soft_limit = file_size_limit,
-                .hard_limit = file_size_limit,
-            },
-        };
-        for (size_t i = 0; i < (sizeof(resources) / sizeof(resources[0])); i++)
+            // # files open
+            .resource = RLIMIT_NOFILE,
+            .soft_limit = 64,
+            .hard_limit = 64,
+        },
         {
-            ResourceType r = resources[i];
-            struct rlimit limit = {
-                .rlim_cur = r.soft_limit,
-                .rlim_max = r.hard_limit,
-            };
-            if (setrlimit(r.resource, &limit) == -1)
-            {
-                PRINT_ERROR(strerror(errno));
-                goto on_error;
-            }
-        }
-        // 3. Run the AIs in separate directories, so that AIs don't accidentially edit other files.
-        char home_env_start[] = "HOME=";
-        size_t home_env_start_length = strlen(home_env_start);
-        size_t ai_dir_length = strlen(ai_dir);
-        size_t home_env_size = home_env_start_length + ai_dir_length + 1;
+            // max file size
+            .resource = RLIMIT_FSIZE,
+            .soft_limit = file_size_limit,
+            .hard_limit = file_size_limit,
+        },
+    };
+    for (size_t i = 0; i < (sizeof(resources) / sizeof(resources[0])); i++)
+    {
+        ResourceType r = resources[i];
+        struct rlimit limit = {
+            .rlim_cur = r.soft_limit,
+            .rlim_max = r.hard_limit,
+        };
+        if (setrlimit(r.resource, &limit) == -1) goto on_error;
+    }
+    // 3. Run the AIs in separate directories (HOME is set in the parent).
+    if (chdir(args->ai_dir) == -1) goto on_error;
+    // 4. Close unwanted file descriptors.
+    // NOTE(mattg): This one is handled elsewhere, look for FD_CLOEXEC
+
+    if (sigprocmask(SIG_SETMASK, &args->signal_mask, NULL) == -1) goto on_error;
+    execve(args->ai_path, args->argv, args->envp);
+on_error:
+    args->error = errno;
+    _exit(1); // just exit the child process.
+}
 
-        char *home_env = BShip_Allocate(home_env_size);
-        memset(home_env, 0, home_env_size);
+static void AIConnection_Reset(BShip_AIConnection *ai_conn)
+{
+    ai_conn->socket_desc = -1;
+    ai_conn->process_id = 0;
+    ai_conn->pid_desc = -1;
+    ai_conn->reactor = NULL;
+    ai_conn->read_error = ERROR_SUCCESS;
+    ai_conn->read_start = 0;
+    ai_conn->read_end = 0;
+    ai_conn->framed = false;
+    ai_conn->forked = false;
+    ai_conn->usage_measured = false;
+}
 
-        memcpy(home_env, home_env_start, home_env_start_length);
-        memcpy(&home_env[home_env_start_length], ai_dir, ai_dir_length);
-        if (chdir(ai_dir) == -1)
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+// Counts the threads of every process the user runs, which is what RLIMIT_NPROC is checked against.
+static rlim_t Process_CountUserThreads(void)
+{
+    DIR *proc_dir = opendir("/proc");
+    if (proc_dir == NULL)
+    {
+        PRINT_ERROR(strerror(errno));
+        return 0;
+    }
+    uid_t user = getuid();
+    rlim_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(proc_dir)) != NULL)
+    {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9')
         {
-            PRINT_ERROR(strerror(errno));
-            goto on_error;
+            continue;
         }
-        // 4. Close unwanted file descriptors.
-        // NOTE(mattg): This one is handled elsewhere, look for FD_CLOEXEC
-        // 5. Restrict ENV variables to just the basics.
-        char *argv[] = {
-            (char *)ai_path,
-            (char *)socket_path,
-            NULL
-        };
-        char *envp[] = {
-            "PATH=/usr/bin:/bin",
-            home_env, // created from the ai_dir calculation
-            "TMPDIR=/tmp",
-            NULL
-        };
-        
-        if (execve(ai_path, argv, envp) == -1)
+        // NOTE(mattg): a process's task directory has a link for each of its threads, on top of . and ..
+        char task_path[sizeof("/proc//task") + NAME_MAX];
+        snprintf(task_path, sizeof(task_path), "/proc/%s/task", entry->d_name);
+        struct stat statbuf = {0};
+        if (stat(task_path, &statbuf) == 0 && statbuf.st_uid == user && statbuf.st_nlink > 2)
         {
-            PRINT_ERROR(strerror(errno));
-            goto on_error;
+            count += statbuf.st_nlink - 2;
         }
-on_error:
-        _exit(1); // just exit the child process.
-    }
-    else if (ai_conn->process_id == -1)
-    {
-        // fork error
-        PRINT_ERROR(strerror(errno));
-        BShip_AIConnection_KillProcess(ai_conn);
-        return ERROR_PROCESS_FAILED;
     }
-    // server, return
-    return ERROR_SUCCESS;
+    closedir(proc_dir);
+    return count;
 }
 
-bool BShip_AIConnection_WaitProcess(BShip_AIConnection *ai_conn, bool debug)
+// Gets the process's parent and process group, returns false when it's gone.
+static bool Process_GetStat(pid_t process_id, pid_t *parent, pid_t *group)
 {
-    if (ai_conn == NULL)
+    char stat_path[64];
+    snprintf(stat_path, sizeof(stat_path), "/proc/%d/stat", (int)process_id);
+    int stat_desc = open(stat_path, O_RDONLY | O_CLOEXEC);
+    if (stat_desc == -1)
     {
         return false;
     }
-    if (ai_conn->process_id == -1) {
-        ai_conn->process_id = 0;
+    char buffer[512];
+    ssize_t length = read(stat_desc, buffer, sizeof(buffer) - 1);
+    close(stat_desc);
+    if (length <= 0)
+    {
         return false;
     }
-    int status = 0;
+    buffer[length] = '\0';
+    // NOTE(mattg): the name in parentheses can have anything in it, so look for the parent after the last ')'.
+    char *name_end = strrchr(buffer, ')');
+    int parent_id = -1, group_id = -1;
+    if (name_end == NULL || sscanf(name_end + 1, " %*c %d %d", &parent_id, &group_id) != 2)
+    {
+        return false;
+    }
+    *parent = (pid_t)parent_id;
+    *group = (pid_t)group_id;
+    return true;
+}
+#endif
 
-    if (debug)
+#ifdef __linux__
+static ssize_t Process_ReadFile(pid_t process_id, char *name, char *buffer, size_t size)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", (int)process_id, name);
+    int desc = open(path, O_RDONLY | O_CLOEXEC);
+    if (desc == -1)
     {
-        waitpid(ai_conn->process_id, &status, 0);
-        return true;
+        return -1;
     }
-    struct timespec sleep_time = {
-        .tv_sec = 0,
-        .tv_nsec = 5 * 1000 * 1000, // 5 ms
-    };
+    ssize_t length = read(desc, buffer, size - 1);
+    close(desc);
+    if (length >= 0)
+    {
+        buffer[length] = '\0';
+    }
+    return length;
+}
 
-    for (int i = 0; i < 100; i++)
+static uint64_t Process_GetStatusValue(char *status, char *key)
+{
+    char *line = strstr(status, key);
+    unsigned long long value = 0;
+    if (line == NULL || sscanf(line + strlen(key), " %llu", &value) != 1)
     {
-        pid_t result = waitpid(ai_conn->process_id, &status, WNOHANG);
-        switch (result)
-        {
-        case -1:
-            PRINT_ERROR(strerror(errno));
-            return false;
-            break;
-        default:
-            if (result == ai_conn->process_id)
-            {
-                return true;
-            }
-        }
+        return 0;
+    }
+    return (uint64_t)value;
+}
 
-        nanosleep(&sleep_time, NULL);
+// Reads what a running process used so far, the same things wait4() would give once it exits.
+// NOTE(mattg): the context switches in status are only the main thread's, wait4() counts every thread.
+static bool Process_GetUsage(pid_t process_id, BShip_AIUsage *usage)
+{
+    char buffer[2048];
+    if (Process_ReadFile(process_id, "stat", buffer, sizeof(buffer)) <= 0)
+    {
+        return false;
+    }
+    // NOTE(mattg): utime, stime, cutime and cstime are fields 14 to 17, counting from the pid.
+    char *name_end = strrchr(buffer, ')');
+    unsigned long long user_ticks = 0, system_ticks = 0;
+    long long child_user_ticks = 0, child_system_ticks = 0;
+    if (name_end == NULL || sscanf(name_end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %lld %lld",
+        &user_ticks, &system_ticks, &child_user_ticks, &child_system_ticks) != 4)
+    {
+        return false;
     }
+    double ticks_per_second = (double)sysconf(_SC_CLK_TCK);
+    usage->user_seconds = (double)(user_ticks + (unsigned long long)child_user_ticks) / ticks_per_second;
+    usage->system_seconds = (double)(system_ticks + (unsigned long long)child_system_ticks) / ticks_per_second;
 
-    return false;
+    if (Process_ReadFile(process_id, "status", buffer, sizeof(buffer)) <= 0)
+    {
+        return false;
+    }
+    usage->max_resident_kilobytes = Process_GetStatusValue(buffer, "VmHWM:");
+    usage->voluntary_context_switches = Process_GetStatusValue(buffer, "\nvoluntary_ctxt_switches:");
+    usage->involuntary_context_switches = Process_GetStatusValue(buffer, "nonvoluntary_ctxt_switches:");
+    usage->measured = true;
+    return true;
 }
+#endif
 
-void BShip_AIConnection_KillProcess(BShip_AIConnection *ai_conn)
+// A copy_capacity above 0 starts the AI as a zygote, which can have that many copies running at once.
+static BShip_ErrorType AIConnection_StartProcess(BShip_AIConnection *ai_conn, char *socket_path,
+    char *ai_path, char *ai_dir, uint32_t copy_capacity)
 {
-    if (ai_conn == NULL)
+    assert(ai_conn != NULL);
+    assert(ai_path != NULL);
+    AIConnection_Reset(ai_conn);
+
+    if (!BShip_PathIsExecutable(ai_path))
     {
-        return;
+        PRINT_ERROR_F("AI file %s is not an executable!", ai_path);
+        return ERROR_AI_PATH_ISSUE;
     }
-    PRINT_ERROR("AI has not exited, killing...");
-    if (ai_conn->process_id != -1 && ai_conn->process_id != 0)
+
+    if (!BShip_PathIsDirectory(ai_dir))
+    {
+        PRINT_ERROR_F("AI directory %s is not a directory!", ai_dir);
+        return ERROR_AI_PATH_ISSUE;
+    }
+
+    // NOTE(mattg): without a socket path, connect the AI through a socket pair instead. Both ends are
+    // FD_CLOEXEC so that AIs started at the same time by other threads can't inherit them.
+    int pair_desc[2] = {-1, -1};
+    if (socket_path == NULL)
     {
-        if (kill(-(ai_conn->process_id), SIGKILL) == -1)
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair_desc) == -1)
         {
             PRINT_ERROR(strerror(errno));
+            return ERROR_CONNECTION_FAILED;
         }
-        if (waitpid(ai_conn->process_id, NULL, 0) == -1)
+        socket_path = BSHIP_SOCKET_PAIR_ARG;
+    }
+    ai_conn->socket_desc = pair_desc[0];
+
+    // 3. Run the AIs in separate directories, so that AIs don't accidentially edit other files.
+    char home_env[BSHIP_HOME_ENV_SIZE_MAX];
+    int home_env_length = snprintf(home_env, sizeof(home_env), "%s%s", BSHIP_HOME_ENV_START, ai_dir);
+    if (home_env_length < 0 || (size_t)home_env_length >= sizeof(home_env))
+    {
+        PRINT_ERROR_F("AI directory %s is too long!", ai_dir);
+        if (pair_desc[1] != -1)
         {
-            PRINT_ERROR(strerror(errno));
+            close(pair_desc[1]);
         }
+        return ERROR_AI_PATH_ISSUE;
     }
-    ai_conn->process_id = 0;
-}
+    // 5. Restrict ENV variables to just the basics.
+    char *argv[] = {
+        (char *)ai_path,
+        (char *)socket_path,
+        NULL
+    };
+    char *envp[] = {
+        "PATH=/usr/bin:/bin",
+        home_env, // created from the ai_dir calculation
+        "TMPDIR=/tmp",
+        copy_capacity > 0 ? BSHIP_ZYGOTE_ENV : NULL,
+        NULL
+    };
+    BShip_AIProcessArgs args = {
+        .ai_path = ai_path,
+        .ai_dir = ai_dir,
+        .argv = argv,
+        .envp = envp,
+        .pair_desc = pair_desc[1],
+        .process_limit = BSHIP_AI_PROCESS_LIMIT,
+        .error = 0,
+    };
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+    if (copy_capacity > 0)
+    {
+        args.process_limit = Process_CountUserThreads() + BSHIP_AI_PROCESS_LIMIT + copy_capacity;
+    }
+#endif
 
-BShip_ErrorType BShip_AIConnection_Accept(BShip_AIConnection *ai_conn, BShip_Connection *conn, bool debug)
-{
-    assert(conn != NULL);
-    assert(ai_conn != NULL);
-    if (listen(conn->socket_desc, 1) == -1)
+    // NOTE(mattg): no signal handler can run in the child while it shares our memory, it unblocks them right
+    // before execve, after putting every handler back to the default.
+    sigset_t all_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &args.signal_mask);
+#ifdef __linux__
+    // NOTE(mattg): the child shares our memory (and we wait) until it calls execve, so none of the controller's
+    // page tables are copied, which for a big arena is most of what fork() costs. posix_spawn() can't set the
+    // resource limits, which is why it's clone().
+    void *stack = mmap(NULL, BSHIP_SPAWN_STACK_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED)
     {
-        PRINT_ERROR(strerror(errno));
-        return ERROR_CONNECTION_FAILED;
+        ai_conn->process_id = -1;
     }
-    
-    if (!debug)
+    else
     {
-        struct pollfd pfd = {
+        ai_conn->process_id = clone(AIProcess_Exec, (uint8_t *)stack + BSHIP_SPAWN_STACK_SIZE,
+            CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+        munmap(stack, BSHIP_SPAWN_STACK_SIZE);
+    }
+#else
+    ai_conn->process_id = fork();
+    if (ai_conn->process_id == 0)
+    {
+        AIProcess_Exec(&args);
+    }
+#endif
+    pthread_sigmask(SIG_SETMASK, &args.signal_mask, NULL);
+
+    if (pair_desc[1] != -1)
+    {
+        close(pair_desc[1]);
+    }
+    if (ai_conn->process_id == -1)
+    {
+        // fork error
+        PRINT_ERROR(strerror(errno));
+        BShip_AIConnection_KillProcess(ai_conn);
+        return ERROR_PROCESS_FAILED;
+    }
+    if (args.error != 0)
+    {
+        // NOTE(mattg): the child has already exited, it only shared our memory long enough to say why.
+        PRINT_ERROR_F("AI %s could not be started: %s", ai_path, strerror(args.error));
+        waitpid(ai_conn->process_id, NULL, 0);
+        ai_conn->process_id = -1;
+        return ERROR_PROCESS_FAILED;
+    }
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // NOTE(mattg): our own child's pid isn't reused before we wait on it, so it's safe to open its pidfd by pid.
+    ai_conn->pid_desc = (int32_t)syscall(SYS_pidfd_open, ai_conn->process_id, 0);
+#endif
+    // server, return
+    return ERROR_SUCCESS;
+}
+
+BShip_ErrorType BShip_AIConnection_StartProcess(BShip_AIConnection *ai_conn, char *socket_path,
+    char *ai_path, char *ai_dir)
+{
+    return AIConnection_StartProcess(ai_conn, socket_path, ai_path, ai_dir, 0);
+}
+
+// Reads what the zygote answers with, for being ready and for each fork.
+static BShip_ErrorType AIZygote_ReadReply(BShip_AIZygote *zygote, int32_t *reply, bool debug)
+{
+    if (!debug)
+    {
+        struct pollfd pfd = {
+            .fd = zygote->control.socket_desc,
+            .events = POLLIN,
+        };
+        int rc = poll(&pfd, 1, BSHIP_TIMEOUT_MILLISECONDS);
+        switch (rc)
+        {
+        case -1:
+            PRINT_ERROR(strerror(errno));
+            return ERROR_RECEIVE_FAILED;
+            break;
+        case 0:
+            PRINT_ERROR("Waiting for an AI zygote timed out!");
+            return ERROR_RECEIVE_TIMEOUT;
+            break;
+        default:
+            break;
+        }
+    }
+    ssize_t received = recv(zygote->control.socket_desc, reply, sizeof(*reply), MSG_WAITALL);
+    if (received != (ssize_t)sizeof(*reply))
+    {
+        PRINT_ERROR(received == -1 ? strerror(errno) : "AI zygote closed its control socket!");
+        return ERROR_RECEIVE_FAILED;
+    }
+    return ERROR_SUCCESS;
+}
+
+BShip_ErrorType BShip_AIZygote_Start(BShip_AIZygote *zygote, char *ai_path, char *ai_dir, uint32_t copy_capacity,
+    bool debug)
+{
+    assert(zygote != NULL);
+    assert(copy_capacity > 0);
+#ifndef BSHIP_ZYGOTE_SUPPORTED
+    // NOTE(mattg): its copies couldn't be held to the process limit, so the AI is always started the normal way.
+    (void)ai_path;
+    (void)ai_dir;
+    (void)copy_capacity;
+    (void)debug;
+    AIConnection_Reset(&zygote->control);
+    return ERROR_PROCESS_FAILED;
+#else
+    // NOTE(mattg): the control socket is always a socket pair, whatever the matches connect with.
+    BShip_ErrorType error = AIConnection_StartProcess(&zygote->control, NULL, ai_path, ai_dir, copy_capacity);
+    if (error == ERROR_SUCCESS)
+    {
+        int32_t reply = -1;
+        error = AIZygote_ReadReply(zygote, &reply, debug);
+        if (error == ERROR_SUCCESS && reply != BSHIP_ZYGOTE_READY)
+        {
+            PRINT_ERROR_F("AI %s did not start as a zygote!", ai_path);
+            error = ERROR_PROCESS_FAILED;
+        }
+    }
+    if (error != ERROR_SUCCESS)
+    {
+        BShip_AIZygote_Stop(zygote, debug);
+    }
+    return error;
+#endif
+}
+
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+// Makes sure a copy the zygote just forked has the process limit every other AI starts with, which the copy should
+// have set itself already. Only a child of the zygote is touched, so a zygote can't point this at some other process
+// of the user. A copy that is a child but can't be limited is killed. The pidfd is kept with the connection.
+static bool AIZygote_LimitCopy(BShip_AIZygote *zygote, BShip_AIConnection *ai_conn, pid_t process_id)
+{
+    int pid_desc = (int)syscall(SYS_pidfd_open, process_id, 0);
+    if (pid_desc == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+    // NOTE(mattg): the pidfd stays with the process it was opened for, so while it's alive the pid is still its.
+    pid_t parent = -1, group = -1;
+    bool is_child = Process_GetStat(process_id, &parent, &group) && parent == zygote->control.process_id &&
+        syscall(SYS_pidfd_send_signal, pid_desc, 0, NULL, 0) == 0;
+    struct rlimit limit = {
+        .rlim_cur = BSHIP_AI_PROCESS_LIMIT,
+        .rlim_max = BSHIP_AI_PROCESS_LIMIT,
+    };
+    bool limited = is_child && prlimit(process_id, RLIMIT_NPROC, &limit, NULL) == 0;
+    if (is_child && !limited)
+    {
+        PRINT_ERROR(strerror(errno));
+        syscall(SYS_pidfd_send_signal, pid_desc, SIGKILL, NULL, 0);
+    }
+    if (!limited)
+    {
+        close(pid_desc);
+        return false;
+    }
+    ai_conn->pid_desc = pid_desc;
+    return true;
+}
+#endif
+
+BShip_ErrorType BShip_AIConnection_StartFromZygote(BShip_AIConnection *ai_conn, BShip_AIZygote *zygote, bool debug)
+{
+    assert(ai_conn != NULL);
+    assert(zygote != NULL);
+    AIConnection_Reset(ai_conn);
+    ai_conn->forked = true;
+
+    int pair_desc[2] = {-1, -1};
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair_desc) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        ai_conn->process_id = -1;
+        return ERROR_CONNECTION_FAILED;
+    }
+    ai_conn->socket_desc = pair_desc[0];
+
+    char request = BSHIP_ZYGOTE_FORK;
+    struct iovec request_vector = {
+        .iov_base = &request,
+        .iov_len = sizeof(request),
+    };
+    union {
+        struct cmsghdr header; // NOTE(mattg): only here to align the buffer.
+        uint8_t buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr request_header = {
+        .msg_iov = &request_vector,
+        .msg_iovlen = 1,
+        .msg_control = control.buffer,
+        .msg_controllen = sizeof(control.buffer),
+    };
+    struct cmsghdr *control_header = CMSG_FIRSTHDR(&request_header);
+    control_header->cmsg_level = SOL_SOCKET;
+    control_header->cmsg_type = SCM_RIGHTS;
+    control_header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(control_header), &pair_desc[1], sizeof(int));
+
+    ssize_t sent = sendmsg(zygote->control.socket_desc, &request_header, MSG_NOSIGNAL);
+    close(pair_desc[1]);
+    // NOTE(mattg): on any error there's no copy to wait on, so the connection is closed here.
+    if (sent != (ssize_t)sizeof(request))
+    {
+        PRINT_ERROR(sent == -1 ? strerror(errno) : "Could not ask the AI zygote to fork!");
+        BShip_AIConnection_Close(ai_conn);
+        ai_conn->process_id = -1;
+        return ERROR_PROCESS_FAILED;
+    }
+
+    int32_t reply = -1;
+    if (AIZygote_ReadReply(zygote, &reply, debug) != ERROR_SUCCESS || reply <= 0)
+    {
+        PRINT_ERROR("AI zygote could not fork!");
+        BShip_AIConnection_Close(ai_conn);
+        ai_conn->process_id = -1;
+        return ERROR_PROCESS_FAILED;
+    }
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+    if (!AIZygote_LimitCopy(zygote, ai_conn, reply))
+    {
+        PRINT_ERROR("AI zygote's copy could not be limited!");
+        BShip_AIConnection_Close(ai_conn);
+        ai_conn->process_id = -1;
+        return ERROR_PROCESS_FAILED;
+    }
+#endif
+    ai_conn->process_id = reply;
+    return ERROR_SUCCESS;
+}
+
+void BShip_AIZygote_Stop(BShip_AIZygote *zygote, bool debug)
+{
+    // NOTE(mattg): closing the control socket tells the zygote to exit, the copies it forked play their matches out.
+    BShip_AIConnection_Close(&zygote->control);
+    if (!BShip_AIConnection_WaitProcess(&zygote->control, debug))
+    {
+        BShip_AIConnection_KillProcess(&zygote->control);
+    }
+}
+
+// Waits on the AI's pidfd, which is readable as soon as it exits, so it wakes up right away and uses no CPU while
+// waiting. Returns 1 once the AI exited, 0 when the timeout (-1 for none) ran out, and -1 without a pidfd, where the
+// caller has to poll for it instead.
+static int AIConnection_WaitExit(BShip_AIConnection *ai_conn, int timeout_milliseconds)
+{
+    if (ai_conn->pid_desc == -1)
+    {
+        return -1;
+    }
+    struct pollfd pfd = {
+        .fd = ai_conn->pid_desc,
+        .events = POLLIN,
+    };
+    int rc = 0;
+    do
+    {
+        rc = poll(&pfd, 1, timeout_milliseconds);
+    } while (rc == -1 && errno == EINTR);
+    if (rc == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+    }
+    return rc;
+}
+
+static void AIConnection_ClosePidDesc(BShip_AIConnection *ai_conn)
+{
+    if (ai_conn->pid_desc != -1)
+    {
+        close(ai_conn->pid_desc);
+        ai_conn->pid_desc = -1;
+    }
+}
+
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+// Kills an AI forked by a zygote through its pidfd, since the zygote reaps it and its pid can go to another process.
+// NOTE(mattg): the copy is only trusted to be in its own process group when the group is named after it while the
+// pidfd says it's still there (a pid isn't reused before the zygote reaps it). Otherwise only the copy is killed.
+static void AIConnection_KillForked(BShip_AIConnection *ai_conn)
+{
+    if (ai_conn->pid_desc == -1)
+    {
+        return;
+    }
+    pid_t parent = -1, group = -1;
+    if (Process_GetStat(ai_conn->process_id, &parent, &group) && group == ai_conn->process_id &&
+        syscall(SYS_pidfd_send_signal, ai_conn->pid_desc, 0, NULL, 0) == 0)
+    {
+        kill(-group, SIGKILL);
+    }
+    if (syscall(SYS_pidfd_send_signal, ai_conn->pid_desc, SIGKILL, NULL, 0) == -1 && errno != ESRCH)
+    {
+        PRINT_ERROR(strerror(errno));
+    }
+}
+#endif
+
+bool BShip_AIConnection_WaitProcess(BShip_AIConnection *ai_conn, bool debug)
+{
+    if (ai_conn == NULL)
+    {
+        return false;
+    }
+    if (ai_conn->process_id == -1) {
+        ai_conn->process_id = 0;
+        return false;
+    }
+    if (ai_conn->process_id == 0)
+    {
+        return true; // NOTE(mattg): already waited on (or killed).
+    }
+    int exited = AIConnection_WaitExit(ai_conn, debug ? -1 : BSHIP_TIMEOUT_MILLISECONDS);
+    if (exited == 0)
+    {
+        return false;
+    }
+    if (ai_conn->forked)
+    {
+        // NOTE(mattg): it always has a pidfd, and its zygote reaps it, so there's nothing to wait4() on.
+        if (exited != 1)
+        {
+            return false;
+        }
+        AIConnection_ClosePidDesc(ai_conn);
+        ai_conn->process_id = 0;
+        return true;
+    }
+    int status = 0;
+
+    if (debug || exited == 1)
+    {
+        ai_conn->usage_measured = wait4(ai_conn->process_id, &status, 0, &ai_conn->usage) == ai_conn->process_id;
+        AIConnection_ClosePidDesc(ai_conn);
+        ai_conn->process_id = 0;
+        return true;
+    }
+    // NOTE(mattg): without pidfds, check in on it every few milliseconds.
+    struct timespec sleep_time = {
+        .tv_sec = 0,
+        .tv_nsec = 5 * 1000 * 1000, // 5 ms
+    };
+
+    for (int i = 0; i < 100; i++)
+    {
+        pid_t result = wait4(ai_conn->process_id, &status, WNOHANG, &ai_conn->usage);
+        switch (result)
+        {
+        case -1:
+            PRINT_ERROR(strerror(errno));
+            return false;
+            break;
+        default:
+            if (result == ai_conn->process_id)
+            {
+                ai_conn->usage_measured = true;
+                ai_conn->process_id = 0;
+                return true;
+            }
+        }
+
+        nanosleep(&sleep_time, NULL);
+    }
+
+    return false;
+}
+
+void BShip_AIConnection_KillProcess(BShip_AIConnection *ai_conn)
+{
+    if (ai_conn == NULL)
+    {
+        return;
+    }
+    if (ai_conn->process_id != -1 && ai_conn->process_id != 0)
+    {
+        PRINT_ERROR("AI has not exited, killing...");
+        if (ai_conn->forked)
+        {
+#ifdef BSHIP_ZYGOTE_SUPPORTED
+            AIConnection_KillForked(ai_conn);
+#endif
+            if (AIConnection_WaitExit(ai_conn, BSHIP_TIMEOUT_MILLISECONDS) != 1)
+            {
+                PRINT_ERROR("AI could not be killed!");
+            }
+        }
+        else
+        {
+            if (kill(-(ai_conn->process_id), SIGKILL) == -1)
+            {
+                PRINT_ERROR(strerror(errno));
+            }
+            if (wait4(ai_conn->process_id, NULL, 0, &ai_conn->usage) == -1)
+            {
+                PRINT_ERROR(strerror(errno));
+            }
+            else
+            {
+                ai_conn->usage_measured = true;
+            }
+        }
+    }
+    AIConnection_ClosePidDesc(ai_conn);
+    ai_conn->process_id = 0;
+}
+
+bool BShip_AIConnection_GetUsage(BShip_AIConnection *ai_conn, BShip_AIUsage *usage)
+{
+    assert(ai_conn != NULL);
+    assert(usage != NULL);
+    memset(usage, 0, sizeof(BShip_AIUsage));
+    if (!ai_conn->usage_measured)
+    {
+        return false;
+    }
+    struct rusage *ru = &ai_conn->usage;
+    usage->user_seconds = (double)ru->ru_utime.tv_sec + ((double)ru->ru_utime.tv_usec / 1e6);
+    usage->system_seconds = (double)ru->ru_stime.tv_sec + ((double)ru->ru_stime.tv_usec / 1e6);
+#ifdef __APPLE__
+    usage->max_resident_kilobytes = (uint64_t)ru->ru_maxrss / 1024; // NOTE(mattg): bytes on macOS, kilobytes on Linux.
+#else
+    usage->max_resident_kilobytes = (uint64_t)ru->ru_maxrss;
+#endif
+    usage->voluntary_context_switches = (uint64_t)ru->ru_nvcsw;
+    usage->involuntary_context_switches = (uint64_t)ru->ru_nivcsw;
+    usage->measured = true;
+    return true;
+}
+
+bool BShip_AIConnection_SampleUsage(BShip_AIConnection *ai_conn, BShip_AIUsage *usage)
+{
+    assert(ai_conn != NULL);
+    assert(usage != NULL);
+    memset(usage, 0, sizeof(BShip_AIUsage));
+#ifdef __linux__
+    if (ai_conn->process_id == -1 || ai_conn->process_id == 0)
+    {
+        return false;
+    }
+    // NOTE(mattg): a forked AI's pid goes back to the system as soon as its zygote reaps it, so what was read is only
+    // this AI's if the pidfd says it's still running afterwards. Our own child's pid stays ours until we wait on it.
+    if (!Process_GetUsage(ai_conn->process_id, usage) || (ai_conn->forked && AIConnection_WaitExit(ai_conn, 0) != 0))
+    {
+        memset(usage, 0, sizeof(BShip_AIUsage));
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+BShip_ErrorType BShip_AIConnection_Accept(BShip_AIConnection *ai_conn, BShip_Connection *conn, bool debug)
+{
+    assert(conn != NULL);
+    assert(ai_conn != NULL);
+
+    if (conn->socket_pair || ai_conn->forked)
+    {
+        // NOTE(mattg): the AI was already connected when its process was started (or forked by its zygote).
+        return ERROR_SUCCESS;
+    }
+
+    if (!debug)
+    {
+        struct pollfd pfd = {
             .fd = conn->socket_desc,
             .events = POLLIN,
         };
@@ -387,30 +1206,145 @@ BShip_ErrorType BShip_AIConnection_Accept(BShip_AIConnection *ai_conn, BShip_Con
         .sun_family = AF_UNIX,
     };
     socklen_t socket_address_length = sizeof(socket_address);
-    ai_conn->socket_desc = accept(conn->socket_desc, (struct sockaddr *)&socket_address, &socket_address_length);
+    // NOTE(mattg): FD_CLOEXEC right away too, see BShip_Connection_Create.
+    ai_conn->socket_desc = accept4(conn->socket_desc, (struct sockaddr *)&socket_address, &socket_address_length,
+        SOCK_CLOEXEC);
     if (ai_conn->socket_desc == -1) {
         PRINT_ERROR(strerror(errno));
         return ERROR_CONNECTION_FAILED;
     }
 
-    int flags = fcntl(ai_conn->socket_desc, F_GETFD);
-    if (flags == -1)
+    return ERROR_SUCCESS;
+}
+
+// Writes the message the way it goes on the socket, and returns its size.
+static uint32_t AIConnection_WriteFrame(BShip_AIConnection *ai_conn, BShip_Message message, uint8_t *frame)
+{
+    if (!ai_conn->framed)
     {
-        PRINT_ERROR(strerror(errno));
-        return ERROR_CONNECTION_FAILED;
+        memcpy(frame, message.buffer, BSHIP_MESSAGE_SIZE);
+        return BSHIP_MESSAGE_SIZE;
     }
+    // NOTE(mattg): binary messages have zero bytes in them, so the length has to come from the message itself.
+    uint32_t length = message.length;
+    frame[0] = (uint8_t)(length >> 8);
+    frame[1] = (uint8_t)(length & 0xff);
+    memcpy(&frame[BSHIP_FRAME_HEADER_SIZE], message.buffer, length);
+    return BSHIP_FRAME_HEADER_SIZE + length;
+}
 
-    if (fcntl(ai_conn->socket_desc, F_SETFD, flags | FD_CLOEXEC) == -1)
+// Returns the size of the frame at the front of the read buffer, or 0 if it isn't all in yet.
+static uint32_t AIConnection_GetFrameSize(BShip_AIConnection *ai_conn)
+{
+    uint32_t buffered = ai_conn->read_end - ai_conn->read_start;
+    if (!ai_conn->framed)
     {
-        PRINT_ERROR(strerror(errno));
-        return ERROR_CONNECTION_FAILED;
+        return buffered >= BSHIP_MESSAGE_SIZE ? BSHIP_MESSAGE_SIZE : 0;
+    }
+    if (buffered < BSHIP_FRAME_HEADER_SIZE)
+    {
+        return 0;
+    }
+    uint8_t *header = &ai_conn->read_buffer[ai_conn->read_start];
+    uint32_t size = BSHIP_FRAME_HEADER_SIZE + (((uint32_t)header[0] << 8) | header[1]);
+    if (size > BSHIP_FRAME_SIZE_MAX - 1)
+    {
+        // NOTE(mattg): there's no way to find the next message after a broken frame, so the connection is done.
+        if (ai_conn->read_error == ERROR_SUCCESS)
+        {
+            PRINT_ERROR("Message frame received from the AI is too big!");
+            ai_conn->read_error = ERROR_RECEIVE_FAILED;
+        }
+        return 0;
     }
+    return buffered >= size ? size : 0;
+}
 
+static bool AIConnection_HasMessage(BShip_AIConnection *ai_conn)
+{
+    return AIConnection_GetFrameSize(ai_conn) > 0 || ai_conn->read_error != ERROR_SUCCESS;
+}
+
+// Moves what is left in the read buffer to the front, and returns how much room there is after it.
+static uint32_t AIConnection_GetReadSpace(BShip_AIConnection *ai_conn)
+{
+    if (ai_conn->read_start > 0)
+    {
+        uint32_t buffered = ai_conn->read_end - ai_conn->read_start;
+        memmove(ai_conn->read_buffer, &ai_conn->read_buffer[ai_conn->read_start], buffered);
+        ai_conn->read_start = 0;
+        ai_conn->read_end = buffered;
+    }
+    return BSHIP_READ_BUFFER_SIZE - ai_conn->read_end;
+}
+
+// Reads whatever the AI sent so far, without waiting.
+static void AIConnection_Fill(BShip_AIConnection *ai_conn)
+{
+    if (ai_conn->read_error != ERROR_SUCCESS)
+    {
+        return;
+    }
+    uint32_t space = AIConnection_GetReadSpace(ai_conn);
+    if (space == 0)
+    {
+        return;
+    }
+    ssize_t bytes_received = recv(ai_conn->socket_desc, &ai_conn->read_buffer[ai_conn->read_end], space,
+        MSG_DONTWAIT);
+    if (bytes_received == -1)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            return;
+        }
+        PRINT_ERROR(strerror(errno));
+        ai_conn->read_error = ERROR_RECEIVE_FAILED;
+        return;
+    }
+    else if (bytes_received == 0)
+    {
+        ai_conn->read_error = ERROR_RECEIVE_EMPTY_MESSAGE;
+        return;
+    }
+    ai_conn->read_end += (uint32_t)bytes_received;
+}
 
+// Takes the message at the front of the read buffer.
+static BShip_ErrorType AIConnection_TakeMessage(BShip_AIConnection *ai_conn, BShip_Message *message)
+{
+    uint32_t size = AIConnection_GetFrameSize(ai_conn);
+    if (size == 0)
+    {
+        switch (ai_conn->read_error)
+        {
+        case ERROR_SUCCESS:
+            PRINT_ERROR("No message received from the AI!");
+            return ERROR_RECEIVE_FAILED;
+        case ERROR_RECEIVE_EMPTY_MESSAGE:
+            // received an empty message, usually indicated an early exited AI...
+            PRINT_ERROR("Empty message received from the AI!");
+            break;
+        default:
+            break;
+        }
+        return ai_conn->read_error;
+    }
+    uint8_t *frame = &ai_conn->read_buffer[ai_conn->read_start];
+    uint32_t length = size;
+    if (ai_conn->framed)
+    {
+        frame += BSHIP_FRAME_HEADER_SIZE;
+        length -= BSHIP_FRAME_HEADER_SIZE;
+    }
+    memcpy(message->buffer, frame, length);
+    memset(&message->buffer[length], 0, BSHIP_MESSAGE_SIZE - length);
+    ai_conn->read_start += size;
+    message->length = ai_conn->framed ? length : strnlen(message->buffer, BSHIP_MESSAGE_SIZE - 1);
     return ERROR_SUCCESS;
 }
 
-BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Message message, bool debug)
+static BShip_ErrorType AIConnection_SendSocket(BShip_AIConnection *ai_conn, BShip_Message message, bool debug)
 {
     assert(ai_conn != NULL);
     assert(message.buffer != NULL);
@@ -436,7 +1370,11 @@ BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Messa
             break;
         }
     }
-    if (send(ai_conn->socket_desc, message.buffer, BSHIP_MESSAGE_SIZE, 0) == -1)
+    uint8_t frame[BSHIP_FRAME_SIZE_MAX];
+    uint32_t size = AIConnection_WriteFrame(ai_conn, message, frame);
+    // NOTE(mattg): an AI that exited early must not take the controller (and any other running matches) down
+    // with a SIGPIPE.
+    if (send(ai_conn->socket_desc, frame, size, MSG_NOSIGNAL) == -1)
     {
         PRINT_ERROR(strerror(errno));
         return ERROR_SEND_FAILED;
@@ -444,22 +1382,47 @@ BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Messa
     return ERROR_SUCCESS;
 }
 
+static BShip_ErrorType AIConnection_ReadSocket(BShip_AIConnection *ai_conn, BShip_Message *message)
+{
+    assert(ai_conn != NULL);
+    assert(message != NULL);
+    assert(message->buffer != NULL);
+
+    if (!AIConnection_HasMessage(ai_conn))
+    {
+        AIConnection_Fill(ai_conn);
+    }
+    return AIConnection_TakeMessage(ai_conn, message);
+}
+
 BShip_ErrorType BShip_AIConnection_Receive(BShip_AIConnection *ai_conn, BShip_Message *message, bool debug)
 {
     assert(ai_conn != NULL);
     assert(message != NULL);
     assert(message->buffer != NULL);
 
-    if (!debug)
+    // NOTE(mattg): a message can come in over more than one recv(), but it only gets one timeout.
+    double deadline = BShip_Time_GetSeconds() + (BSHIP_TIMEOUT_MILLISECONDS / 1000.0);
+    while (!AIConnection_HasMessage(ai_conn))
     {
+        int timeout = -1;
+        if (!debug)
+        {
+            double now = BShip_Time_GetSeconds();
+            timeout = deadline <= now ? 0 : (int)(((deadline - now) * 1000.0) + 1.0);
+        }
         struct pollfd pfd = {
             .fd = ai_conn->socket_desc,
             .events = POLLIN,
         };
-        int rc = poll(&pfd, 1, BSHIP_TIMEOUT_MILLISECONDS);
+        int rc = poll(&pfd, 1, timeout);
         switch (rc)
         {
         case -1:
+            if (errno == EINTR)
+            {
+                continue;
+            }
             PRINT_ERROR(strerror(errno));
             return ERROR_RECEIVE_FAILED;
             break;
@@ -470,27 +1433,30 @@ BShip_ErrorType BShip_AIConnection_Receive(BShip_AIConnection *ai_conn, BShip_Me
         default:
             break;
         }
+        AIConnection_Fill(ai_conn);
     }
 
-    int bytes_received = recv(ai_conn->socket_desc, message->buffer, BSHIP_MESSAGE_SIZE, 0);
-    switch (bytes_received)
-    {
-    case -1:
-        PRINT_ERROR(strerror(errno));
-        return ERROR_RECEIVE_FAILED;
-        break;
-    case 0:
-        // received an empty message, usually indicated an early exited AI...
-        PRINT_ERROR("Empty message received from the AI!");
-        return ERROR_RECEIVE_EMPTY_MESSAGE;
-        break;
-    default:
-        break;
-    }
-    message->length = strnlen(message->buffer, BSHIP_MESSAGE_SIZE);
-    return ERROR_SUCCESS;
+    return AIConnection_TakeMessage(ai_conn, message);
 }
 
+void BShip_AIConnection_SetFramed(BShip_AIConnection *ai_conn, bool framed)
+{
+    assert(ai_conn != NULL);
+    ai_conn->framed = framed;
+}
+
+#ifndef BSHIP_PLATFORM_URING
+BShip_ErrorType BShip_AIConnection_Send(BShip_AIConnection *ai_conn, BShip_Message message, bool debug)
+{
+    return AIConnection_SendSocket(ai_conn, message, debug);
+}
+
+BShip_ErrorType BShip_AIConnection_Read(BShip_AIConnection *ai_conn, BShip_Message *message)
+{
+    return AIConnection_ReadSocket(ai_conn, message);
+}
+#endif
+
 void BShip_AIConnection_Close(BShip_AIConnection *ai_conn)
 {
     if (ai_conn->socket_desc > 2) // NOTE(mattg): -1 == socket() error, 0 == stdin, 1 == stdout, 2 == stderr
@@ -500,3 +1466,381 @@ void BShip_AIConnection_Close(BShip_AIConnection *ai_conn)
     ai_conn->socket_desc = 0;
 }
 
+
+#ifndef BSHIP_PLATFORM_URING
+#ifdef __linux__
+typedef struct epoll_event BShip_ReactorReady;
+#else
+typedef struct pollfd BShip_ReactorReady;
+#endif
+
+// NOTE(mattg): what the entry is registered with, the AI's socket, or its pidfd once it's expected to exit.
+static int32_t Reactor_GetDesc(BShip_ReactorEntry *entry)
+{
+    return entry->exiting ? entry->ai_conn->pid_desc : entry->ai_conn->socket_desc;
+}
+
+// NOTE(mattg): what epoll_wait (or poll) fills in, one for each entry, stored right after the entries.
+static BShip_ReactorReady *Reactor_GetReady(BShip_Reactor *reactor)
+{
+    return (BShip_ReactorReady *)&reactor->entries[reactor->capacity];
+}
+
+size_t BShip_Reactor_GetSize(uint32_t capacity)
+{
+    return sizeof(BShip_Reactor) + ((sizeof(BShip_ReactorEntry) + sizeof(BShip_ReactorReady)) * capacity);
+}
+
+bool BShip_Reactor_Create(BShip_Reactor *reactor, uint32_t capacity)
+{
+    assert(reactor != NULL);
+    reactor->length = 0;
+    reactor->capacity = capacity;
+#ifdef __linux__
+    reactor->epoll_desc = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_desc == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+#endif
+    return true;
+}
+
+void BShip_Reactor_Close(BShip_Reactor *reactor)
+{
+    if (reactor == NULL)
+    {
+        return;
+    }
+#ifdef __linux__
+    if (reactor->epoll_desc > 2) // NOTE(mattg): -1 == epoll_create1() error, 0 == stdin, 1 == stdout, 2 == stderr
+    {
+        close(reactor->epoll_desc);
+    }
+    reactor->epoll_desc = -1;
+#endif
+    reactor->length = 0;
+}
+
+bool BShip_Reactor_Add(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, void *data)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    if (reactor->length >= reactor->capacity)
+    {
+        PRINT_ERROR("Reactor is full!");
+        return false;
+    }
+    uint32_t index = reactor->length;
+#ifdef __linux__
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data.u32 = index,
+    };
+    if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_ADD, ai_conn->socket_desc, &event) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+#endif
+    reactor->entries[index] = (BShip_ReactorEntry){
+        .ai_conn = ai_conn,
+        .data = data,
+        .deadline = 0.0,
+        .muted = false,
+        .exiting = false,
+    };
+    ai_conn->reactor = reactor;
+    ai_conn->reactor_index = index;
+    reactor->length++;
+    return true;
+}
+
+void BShip_Reactor_Remove(BShip_Reactor *reactor, BShip_AIConnection *ai_conn)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    uint32_t index = ai_conn->reactor_index;
+    if (index >= reactor->length || reactor->entries[index].ai_conn != ai_conn)
+    {
+        return;
+    }
+#ifdef __linux__
+    if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_DEL, Reactor_GetDesc(&reactor->entries[index]), NULL) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+    }
+#endif
+    ai_conn->reactor = NULL;
+    // swap the last entry into the hole, and point its epoll registration at the new index.
+    reactor->length--;
+    if (index != reactor->length)
+    {
+        BShip_ReactorEntry last = reactor->entries[reactor->length];
+        reactor->entries[index] = last;
+        last.ai_conn->reactor_index = index;
+#ifdef __linux__
+        struct epoll_event event = {
+            .events = last.muted ? 0 : EPOLLIN,
+            .data.u32 = index,
+        };
+        if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_MOD, Reactor_GetDesc(&last), &event) == -1)
+        {
+            PRINT_ERROR(strerror(errno));
+        }
+#endif
+    }
+}
+
+void BShip_Reactor_Expect(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    assert(ai_conn->reactor_index < reactor->length);
+    BShip_ReactorEntry *entry = &reactor->entries[ai_conn->reactor_index];
+    assert(entry->ai_conn == ai_conn);
+    assert(!entry->exiting);
+    entry->deadline = debug ? -1.0 : BShip_Time_GetSeconds() + (BSHIP_TIMEOUT_MILLISECONDS / 1000.0);
+    if (entry->muted)
+    {
+#ifdef __linux__
+        struct epoll_event event = {
+            .events = EPOLLIN,
+            .data.u32 = ai_conn->reactor_index,
+        };
+        if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_MOD, ai_conn->socket_desc, &event) == -1)
+        {
+            PRINT_ERROR(strerror(errno));
+        }
+#endif
+        entry->muted = false;
+    }
+}
+
+bool BShip_Reactor_ExpectExit(BShip_Reactor *reactor, BShip_AIConnection *ai_conn, bool debug)
+{
+    assert(reactor != NULL);
+    assert(ai_conn != NULL);
+    assert(ai_conn->reactor_index < reactor->length);
+    BShip_ReactorEntry *entry = &reactor->entries[ai_conn->reactor_index];
+    assert(entry->ai_conn == ai_conn);
+    if (ai_conn->pid_desc == -1)
+    {
+        return false;
+    }
+#ifdef __linux__
+    // swap the socket's registration for the pidfd's, under the same index.
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data.u32 = ai_conn->reactor_index,
+    };
+    if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_ADD, ai_conn->pid_desc, &event) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+        return false;
+    }
+    if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_DEL, ai_conn->socket_desc, NULL) == -1)
+    {
+        PRINT_ERROR(strerror(errno));
+    }
+#endif
+    entry->exiting = true;
+    entry->muted = false;
+    entry->deadline = debug ? -1.0 : BShip_Time_GetSeconds() + (BSHIP_TIMEOUT_MILLISECONDS / 1000.0);
+    return true;
+}
+
+int32_t BShip_Reactor_Wait(BShip_Reactor *reactor, BShip_ReactorEvent *events, uint32_t capacity)
+{
+    assert(reactor != NULL);
+    assert(events != NULL);
+    if (capacity == 0)
+    {
+        return 0;
+    }
+
+    // NOTE(mattg): an AI can send more than one message at once, the ones already read don't have to be waited on.
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < reactor->length && count < capacity; i++)
+    {
+        BShip_ReactorEntry *entry = &reactor->entries[i];
+        if (entry->deadline != 0.0 && !entry->exiting && AIConnection_HasMessage(entry->ai_conn))
+        {
+            entry->deadline = 0.0;
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = BSHIP_REACTOR_READABLE,
+            };
+        }
+    }
+    if (count > 0)
+    {
+        return (int32_t)count;
+    }
+
+    // the wait only has to last until the closest reply deadline.
+    double now = BShip_Time_GetSeconds();
+    double deadline = 0.0;
+    bool expecting = false;
+    for (uint32_t i = 0; i < reactor->length; i++)
+    {
+        double entry_deadline = reactor->entries[i].deadline;
+        if (entry_deadline == 0.0)
+        {
+            continue;
+        }
+        expecting = true;
+        if (entry_deadline > 0.0 && (deadline == 0.0 || entry_deadline < deadline))
+        {
+            deadline = entry_deadline;
+        }
+    }
+    if (!expecting)
+    {
+        return 0;
+    }
+    int timeout = -1;
+    if (deadline > 0.0)
+    {
+        timeout = deadline <= now ? 0 : (int)(((deadline - now) * 1000.0) + 1.0);
+    }
+
+#ifdef __linux__
+    BShip_ReactorReady *ready = Reactor_GetReady(reactor);
+    int max_ready = capacity < reactor->capacity ? (int)capacity : (int)reactor->capacity;
+    int rc = epoll_wait(reactor->epoll_desc, ready, max_ready, timeout);
+    if (rc == -1)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        PRINT_ERROR(strerror(errno));
+        return -1;
+    }
+    for (int i = 0; i < rc; i++)
+    {
+        uint32_t index = ready[i].data.u32;
+        BShip_ReactorEntry *entry = &reactor->entries[index];
+        if (entry->deadline == 0.0)
+        {
+            // NOTE(mattg): an AI sent something (or exited) without being asked to. Stop listening to it until
+            // a message is expected again, otherwise the level-triggered epoll would keep waking us up for it.
+            struct epoll_event event = {
+                .events = 0,
+                .data.u32 = index,
+            };
+            if (epoll_ctl(reactor->epoll_desc, EPOLL_CTL_MOD, Reactor_GetDesc(entry), &event) == -1)
+            {
+                PRINT_ERROR(strerror(errno));
+            }
+            entry->muted = true;
+            continue;
+        }
+        if (entry->exiting)
+        {
+            entry->deadline = 0.0;
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = BSHIP_REACTOR_EXITED,
+            };
+            continue;
+        }
+        // NOTE(mattg): only part of a message may be in, then keep waiting on the rest.
+        AIConnection_Fill(entry->ai_conn);
+        if (!AIConnection_HasMessage(entry->ai_conn))
+        {
+            continue;
+        }
+        entry->deadline = 0.0;
+        events[count++] = (BShip_ReactorEvent){
+            .ai_conn = entry->ai_conn,
+            .data = entry->data,
+            .type = BSHIP_REACTOR_READABLE,
+        };
+    }
+#else
+    // NOTE(mattg): no epoll here, so fall back to one poll() over every registered connection.
+    BShip_ReactorReady *pfds = Reactor_GetReady(reactor);
+    nfds_t pfd_count = reactor->length;
+    for (nfds_t i = 0; i < pfd_count; i++)
+    {
+        // NOTE(mattg): a negative fd is ignored by poll(), only wait on the AIs a message is expected from.
+        int fd = Reactor_GetDesc(&reactor->entries[i]);
+        pfds[i] = (struct pollfd){
+            .fd = reactor->entries[i].deadline == 0.0 ? -1 : fd,
+            .events = POLLIN,
+        };
+    }
+    int rc = poll(pfds, pfd_count, timeout);
+    if (rc == -1)
+    {
+        if (errno == EINTR)
+        {
+            return 0;
+        }
+        PRINT_ERROR(strerror(errno));
+        return -1;
+    }
+    for (nfds_t i = 0; i < pfd_count && count < capacity; i++)
+    {
+        if (pfds[i].revents == 0)
+        {
+            continue;
+        }
+        BShip_ReactorEntry *entry = &reactor->entries[i];
+        if (entry->exiting)
+        {
+            entry->deadline = 0.0;
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = BSHIP_REACTOR_EXITED,
+            };
+            continue;
+        }
+        AIConnection_Fill(entry->ai_conn);
+        if (!AIConnection_HasMessage(entry->ai_conn))
+        {
+            continue;
+        }
+        entry->deadline = 0.0;
+        events[count++] = (BShip_ReactorEvent){
+            .ai_conn = entry->ai_conn,
+            .data = entry->data,
+            .type = BSHIP_REACTOR_READABLE,
+        };
+    }
+#endif
+
+    now = BShip_Time_GetSeconds();
+    for (uint32_t i = 0; i < reactor->length && count < capacity; i++)
+    {
+        BShip_ReactorEntry *entry = &reactor->entries[i];
+        if (entry->deadline > 0.0 && entry->deadline <= now && entry->exiting)
+        {
+            entry->deadline = 0.0;
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = BSHIP_REACTOR_TIMEOUT,
+            };
+        }
+        else if (entry->deadline > 0.0 && entry->deadline <= now)
+        {
+            // NOTE(mattg): the reply can be in already, when more AIs were ready than fit in events.
+            AIConnection_Fill(entry->ai_conn);
+            entry->deadline = 0.0;
+            events[count++] = (BShip_ReactorEvent){
+                .ai_conn = entry->ai_conn,
+                .data = entry->data,
+                .type = AIConnection_HasMessage(entry->ai_conn) ? BSHIP_REACTOR_READABLE : BSHIP_REACTOR_TIMEOUT,
+            };
+        }
+    }
+    return (int32_t)count;
+}
+#endif
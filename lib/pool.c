@@ -0,0 +1,331 @@
+/**
+ * @file pool.c
+ * @author Matthew Getgen
+ * @brief Keeps AI processes running between matches.
+ * @date 2026-10-16
+ *
+ * An AI that says it supports new matches in its hello doesn't have to exit after match over. When a match ends
+ * cleanly, the AI is told to stay (see NEW_MATCH_KEY), and the pool holds on to it while it waits. The next match
+ * with the same AI path and dir then gets it already connected, which skips starting the process, connecting, and
+ * the hello.
+ *
+ * An AI that says it can be a zygote is started once more as one, after its first match. From then on its matches
+ * get a copy forked from the zygote, which starts out already initialized but doesn't keep anything from the last
+ * match. Forked AIs are never kept, a fresh copy costs about as much as reusing one.
+ *
+ * A pool isn't thread safe, each contest worker has its own.
+ */
+
+#include "battleshipslib.h"
+
+typedef enum {
+    AI_POOL_ENTRY_FREE,
+    AI_POOL_ENTRY_IDLE,
+    AI_POOL_ENTRY_IN_USE,
+} BShip_AIPoolEntryState;
+
+typedef struct {
+    BShip_AIPool *pool; // NOTE(mattg): NULL for an AI a match started on its own, it's stopped when the match ends.
+    BShip_AIConnection *conn;
+    char *path;
+    char *dir;
+    // NOTE(mattg): what the AI said in its hello, for the matches that reuse it.
+    char name[BSHIP_MESSAGE_NAME_SIZE_MAX];
+    char authors[BSHIP_MESSAGE_NAME_SIZE_MAX];
+    BShip_MessageEncoding encoding;
+    bool framed;
+    bool new_match;
+    bool zygote; // NOTE(mattg): it said it can be a zygote, and the pool has one for it.
+    bool forked;
+    bool started;
+    // NOTE(mattg): what the AI had used when its last match ended, so the next match only counts what it used.
+    BShip_AIUsage usage_base;
+    uint64_t last_used;
+    BShip_AIPoolEntryState state;
+} BShip_AIPoolEntry;
+
+typedef struct {
+    char *path;
+    char *dir;
+    BShip_AIZygote *zygote;
+    uint64_t last_used;
+    bool used;
+    bool started;
+    bool failed; // NOTE(mattg): it couldn't be started as a zygote, so its AI is started the normal way instead.
+} BShip_AIPoolZygote;
+
+struct BShip_AIPool {
+    BShip_AIPoolEntry *entries;
+    uint32_t capacity;
+    BShip_AIPoolZygote *zygotes;
+    uint32_t zygote_capacity;
+    uint64_t clock;
+};
+
+// Closes the connection, which tells an AI waiting for a new match to exit.
+static void AIPoolEntry_Close(BShip_AIPoolEntry *entry)
+{
+    if (entry->started)
+    {
+        BShip_AIConnection_Close(entry->conn);
+    }
+}
+
+static void AIPoolEntry_Stop(BShip_AIPoolEntry *entry, bool debug)
+{
+    if (!entry->started)
+    {
+        return;
+    }
+    // NOTE(mattg): with socket pairs an AI is connected as soon as it is started, so always close.
+    BShip_AIConnection_Close(entry->conn);
+    // TODO(mattg): hook this up with the error handling (status code, exited vs hung)
+    if (!BShip_AIConnection_WaitProcess(entry->conn, debug))
+    {
+        BShip_AIConnection_KillProcess(entry->conn);
+    }
+    entry->started = false;
+}
+
+// Hands out an idle AI started from path and dir, or else an entry to start one in, making room by stopping the AI
+// that has been idle the longest. Returns NULL when every entry is in use.
+static BShip_AIPoolEntry *AIPool_Acquire(BShip_AIPool *pool, char *path, char *dir, bool debug)
+{
+    BShip_AIPoolEntry *free_entry = NULL;
+    BShip_AIPoolEntry *oldest_entry = NULL;
+    for (uint32_t i = 0; i < pool->capacity; i++)
+    {
+        BShip_AIPoolEntry *entry = &pool->entries[i];
+        switch (entry->state)
+        {
+        case AI_POOL_ENTRY_FREE:
+            if (free_entry == NULL)
+            {
+                free_entry = entry;
+            }
+            break;
+        case AI_POOL_ENTRY_IDLE:
+            if (strcmp(entry->path, path) == 0 && strcmp(entry->dir, dir) == 0)
+            {
+                entry->state = AI_POOL_ENTRY_IN_USE;
+                return entry;
+            }
+            if (oldest_entry == NULL || entry->last_used < oldest_entry->last_used)
+            {
+                oldest_entry = entry;
+            }
+            break;
+        case AI_POOL_ENTRY_IN_USE:
+            break;
+        }
+    }
+
+    BShip_AIPoolEntry *entry = free_entry;
+    if (entry == NULL)
+    {
+        entry = oldest_entry;
+        if (entry == NULL)
+        {
+            return NULL;
+        }
+        AIPoolEntry_Stop(entry, debug);
+    }
+    entry->path = path;
+    entry->dir = dir;
+    entry->zygote = false;
+    entry->forked = false;
+    entry->started = false;
+    memset(&entry->usage_base, 0, sizeof(BShip_AIUsage));
+    entry->state = AI_POOL_ENTRY_IN_USE;
+    return entry;
+}
+
+static BShip_AIPoolZygote *AIPool_FindZygote(BShip_AIPool *pool, char *path, char *dir)
+{
+    for (uint32_t i = 0; i < pool->zygote_capacity; i++)
+    {
+        BShip_AIPoolZygote *zygote = &pool->zygotes[i];
+        if (zygote->used && strcmp(zygote->path, path) == 0 && strcmp(zygote->dir, dir) == 0)
+        {
+            return zygote;
+        }
+    }
+    return NULL;
+}
+
+static void AIPoolZygote_Stop(BShip_AIPoolZygote *zygote, bool debug)
+{
+    if (zygote->started)
+    {
+        BShip_AIZygote_Stop(zygote->zygote, debug);
+    }
+    zygote->started = false;
+}
+
+// Makes room for a zygote of the AI at path and dir, which is only started once a match wants it. Returns false when
+// there isn't any room, or the AI already failed to start as one.
+static bool AIPool_AddZygote(BShip_AIPool *pool, char *path, char *dir, bool debug)
+{
+    BShip_AIPoolZygote *zygote = AIPool_FindZygote(pool, path, dir);
+    if (zygote != NULL)
+    {
+        return !zygote->failed;
+    }
+    for (uint32_t i = 0; i < pool->zygote_capacity; i++)
+    {
+        BShip_AIPoolZygote *candidate = &pool->zygotes[i];
+        if (!candidate->used)
+        {
+            zygote = candidate;
+            break;
+        }
+        if (zygote == NULL || candidate->last_used < zygote->last_used)
+        {
+            zygote = candidate;
+        }
+    }
+    if (zygote == NULL)
+    {
+        return false;
+    }
+    AIPoolZygote_Stop(zygote, debug);
+    zygote->path = path;
+    zygote->dir = dir;
+    zygote->last_used = pool->clock++;
+    zygote->used = true;
+    zygote->failed = false;
+    return true;
+}
+
+// Forks the entry's AI from its zygote, starting the zygote first if it isn't yet. Returns false when the AI doesn't
+// have a zygote (or it broke), and has to be started the normal way.
+static bool AIPool_Fork(BShip_AIPool *pool, BShip_AIPoolEntry *entry, bool debug)
+{
+    BShip_AIPoolZygote *zygote = AIPool_FindZygote(pool, entry->path, entry->dir);
+    if (zygote == NULL || zygote->failed)
+    {
+        return false;
+    }
+    if (!zygote->started)
+    {
+        // NOTE(mattg): every copy running holds one of the pool's entries, so it can't have more than that at once.
+        zygote->started = BShip_AIZygote_Start(zygote->zygote, zygote->path, zygote->dir, pool->capacity,
+            debug) == ERROR_SUCCESS;
+        if (!zygote->started)
+        {
+            zygote->failed = true;
+            return false;
+        }
+    }
+    zygote->last_used = pool->clock++;
+
+    if (BShip_AIConnection_StartFromZygote(entry->conn, zygote->zygote, debug) != ERROR_SUCCESS)
+    {
+        // NOTE(mattg): no copy was started (or it was already killed), so there's nothing to stop.
+        AIPoolZygote_Stop(zygote, debug);
+        zygote->failed = true;
+        return false;
+    }
+    entry->started = true;
+    entry->forked = true;
+    return true;
+}
+
+// Keeps the AI waiting for the next match that wants it, or stops it if it wasn't told to stay.
+static void AIPool_Release(BShip_AIPool *pool, BShip_AIPoolEntry *entry, bool keep, bool debug)
+{
+    assert(entry->state == AI_POOL_ENTRY_IN_USE);
+    if (!keep || !entry->started)
+    {
+        AIPoolEntry_Stop(entry, debug);
+        entry->state = AI_POOL_ENTRY_FREE;
+        return;
+    }
+    // NOTE(mattg): the setup match of the next match goes out the old way, like the first one did.
+    BShip_AIConnection_SetFramed(entry->conn, false);
+    entry->last_used = pool->clock++;
+    entry->state = AI_POOL_ENTRY_IDLE;
+}
+
+size_t BShip_AIPool_CalculateMemorySize(uint32_t capacity, uint32_t zygote_capacity)
+{
+    return sizeof(BShip_AIPool) + ((sizeof(BShip_AIPoolEntry) + BShip_AIConnection_GetSize()) * capacity)
+        + ((sizeof(BShip_AIPoolZygote) + BShip_AIZygote_GetSize()) * zygote_capacity);
+}
+
+BShip_AIPool *BShip_AIPool_Create(BShip_Arena *arena, uint32_t capacity, uint32_t zygote_capacity)
+{
+    assert(arena != NULL);
+    BShip_AIPool *pool = BSHIP_ARENA_PUSH(arena, BShip_AIPool);
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    pool->entries = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_AIPoolEntry, capacity);
+    if (pool->entries == NULL)
+    {
+        return NULL;
+    }
+    pool->capacity = capacity;
+    pool->clock = 0;
+    memset(pool->entries, 0, sizeof(BShip_AIPoolEntry) * capacity);
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        BShip_AIPoolEntry *entry = &pool->entries[i];
+        entry->pool = pool;
+        entry->conn = BShip_Arena_Push(arena, BShip_AIConnection_GetSize());
+        if (entry->conn == NULL)
+        {
+            return NULL;
+        }
+        memset(entry->conn, 0, BShip_AIConnection_GetSize());
+    }
+
+    pool->zygotes = NULL;
+    pool->zygote_capacity = zygote_capacity;
+    if (zygote_capacity == 0)
+    {
+        return pool;
+    }
+    pool->zygotes = BSHIP_ARENA_PUSH_ARRAY(arena, BShip_AIPoolZygote, zygote_capacity);
+    if (pool->zygotes == NULL)
+    {
+        return NULL;
+    }
+    memset(pool->zygotes, 0, sizeof(BShip_AIPoolZygote) * zygote_capacity);
+    for (uint32_t i = 0; i < zygote_capacity; i++)
+    {
+        BShip_AIPoolZygote *zygote = &pool->zygotes[i];
+        zygote->zygote = BShip_Arena_Push(arena, BShip_AIZygote_GetSize());
+        if (zygote->zygote == NULL)
+        {
+            return NULL;
+        }
+        memset(zygote->zygote, 0, BShip_AIZygote_GetSize());
+    }
+    return pool;
+}
+
+void BShip_AIPool_Close(BShip_AIPool *pool, bool debug)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+    // NOTE(mattg): every AI is told to exit before waiting on any of them.
+    for (uint32_t i = 0; i < pool->capacity; i++)
+    {
+        assert(pool->entries[i].state != AI_POOL_ENTRY_IN_USE);
+        AIPoolEntry_Close(&pool->entries[i]);
+    }
+    for (uint32_t i = 0; i < pool->capacity; i++)
+    {
+        AIPoolEntry_Stop(&pool->entries[i], debug);
+        pool->entries[i].state = AI_POOL_ENTRY_FREE;
+    }
+    for (uint32_t i = 0; i < pool->zygote_capacity; i++)
+    {
+        AIPoolZygote_Stop(&pool->zygotes[i], debug);
+        pool->zygotes[i].used = false;
+    }
+}
@@ -1,32 +1,20 @@
 #define _DEFAULT_SOURCE 1
 #include <stdio.h>
-// #include <time.h>
-// #include <x86intrin.h>
 
 #include "lib/battleshipslib.h"
 
-// typedef struct {
-//     long cycles;
-//     struct timespec time;
-// } Timer;
-//
-// static inline void get_time(Timer *timer)
-// {
-//     timer->cycles = __rdtsc();
-//     if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &timer->time) != 0)
-//     {
-//         exit(1);
-//     }
-// }
-//
-// void print_time(Timer start, Timer end)
-// {
-//     long cycles = end.cycles - start.cycles;
-//     long nanoseconds = ((end.time.tv_sec - start.time.tv_sec) * (long)1e9) + (
-//         end.time.tv_nsec - start.time.tv_nsec
-//     );
-//     printf("%ld cycles, %ld ns\n", cycles, nanoseconds);
-// }
+static void PrintAI(BShip_AIMatchData *ai)
+{
+    printf("%s: %u wins, %u losses, %u ties", ai->name != NULL ? ai->name : "?", ai->wins, ai->losses, ai->ties);
+    if (ai->usage.measured)
+    {
+        printf(", %.3fs user, %.3fs system, %lu KB max resident, %lu/%lu context switches",
+            ai->usage.user_seconds, ai->usage.system_seconds, (unsigned long)ai->usage.max_resident_kilobytes,
+            (unsigned long)ai->usage.voluntary_context_switches,
+            (unsigned long)ai->usage.involuntary_context_switches);
+    }
+    printf("\n");
+}
 
 int main(void)
 {
@@ -52,9 +40,12 @@ int main(void)
     char *ai2_path = example_player_2;
     char *ai2_dir = example_player_2_dir;
 
-    BShip_Match_Run(&arena, "/tmp/battleships.sock",
+    BShip_MatchData match = BShip_Match_Run(&arena, "/tmp/battleships.sock",
         ai1_path, ai1_dir, ai2_path, ai2_dir,
-        board_size, games_per_match, false);
+        board_size, games_per_match, 0.0f, false, NULL, NULL, false);
+    printf("%u games in %.3f seconds\n", match.games_played, match.elapsed_time);
+    PrintAI(&match.ai1);
+    PrintAI(&match.ai2);
     BShip_Arena_Destroy(&arena);
     return 0;
 }
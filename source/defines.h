@@ -74,6 +74,13 @@
 #define STATS_KEY           "sta"
 #define PLAYED_KEY          "pd"
 #define BYE_IDX_KEY         "bye"
+#define USAGE_KEY           "use"
+#define USER_SECONDS_KEY    "us"
+#define SYSTEM_SECONDS_KEY  "ss"
+#define MAX_RESIDENT_KEY    "rss"
+#define VOLUNTARY_CS_KEY    "vcs"
+#define INVOLUNTARY_CS_KEY  "ics"
+#define USAGE_MATCHES_KEY   "um"
 
 using namespace std;
 
@@ -218,6 +225,7 @@ struct Ship {
     int8_t row;
     int8_t col;
     int8_t len;
+    int8_t hits_left;  // NOTE: squares of the ship not hit yet, it's dead at 0.
     bool alive;
     Direction dir;
 };
@@ -274,11 +282,22 @@ struct MatchStats {
     int total_ships_killed;
 };
 
+/// @brief What a player's process used in a match, collected by wait4() once it exited.
+struct PlayerUsage {
+    double user_seconds;
+    double system_seconds;
+    long max_resident_kilobytes;
+    long voluntary_context_switches;
+    long involuntary_context_switches;
+    bool measured;
+};
+
 /// @brief Data to store for each player, per match.
 struct MatchPlayer {
     string ai_name;
     string author_name;
     MatchStats stats;
+    PlayerUsage usage;
     Error error;
 };
 
@@ -309,6 +328,8 @@ struct ContestPlayer {
     string ai_name;
     string author_name;
     ContestStats stats;
+    PlayerUsage usage;      // NOTE: summed over usage_matches, max_resident_kilobytes is the most.
+    int usage_matches;
     Executable exec;
     Error error;
 };
@@ -318,6 +339,7 @@ struct ContestMatchPlayer {
     int player_idx;
     Executable exec;
     MatchStats stats;
+    PlayerUsage usage;
     GameResult match_result;
     Error error;
 };
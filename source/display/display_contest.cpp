@@ -50,11 +50,14 @@ void display_contest_leaderboard(DisplayInfo &info, ContestLog &contest) {
         NAME   = "Name",
         WINS   = "Wins",
         LOSSES = "Losses",
-        TIES   = "Ties";
+        TIES   = "Ties",
+        CPU    = "CPU (s)",
+        MEMORY = "Max KB";
     
-    int rank_width = (int)RANK.size(),
-        name_width = (int)NAME.size(),
-        num_width  = 6;
+    int rank_width  = (int)RANK.size(),
+        name_width  = (int)NAME.size(),
+        num_width   = 6,
+        usage_width = 10;
 
     for (int i = 0; i < (int)contest.players.size(); i++) {
         ContestPlayer &player = contest.players.at(i);
@@ -87,7 +90,11 @@ void display_contest_leaderboard(DisplayInfo &info, ContestLog &contest) {
          << setfill(' ') << setw(num_width) << right
          << LOSSES << " " << vertical << " "
          << setfill(' ') << setw(num_width) << right
-         << TIES << " " << vertical;
+         << TIES << " " << vertical << " "
+         << setfill(' ') << setw(usage_width) << right
+         << CPU << " " << vertical << " "
+         << setfill(' ') << setw(usage_width) << right
+         << MEMORY << " " << vertical;
     info.display_row++; 
 
     cout << conio::gotoRowCol(info.display_row, 1)
@@ -95,7 +102,9 @@ void display_contest_leaderboard(DisplayInfo &info, ContestLog &contest) {
          << multiply_string(horizontal, name_width+2) << intersection
          << multiply_string(horizontal, num_width+2) << intersection
          << multiply_string(horizontal, num_width+2) << intersection
-         << multiply_string(horizontal, num_width+2) << end_horizontal;
+         << multiply_string(horizontal, num_width+2) << intersection
+         << multiply_string(horizontal, usage_width+2) << intersection
+         << multiply_string(horizontal, usage_width+2) << end_horizontal;
     info.display_row++;
 
     for (int i = 0; i < (int)sorted_players.size(); i++) {
@@ -115,7 +124,11 @@ void display_contest_leaderboard(DisplayInfo &info, ContestLog &contest) {
              << setfill(' ') << setw(num_width) << right
              << player.stats.losses << " " << vertical << " "
              << setfill(' ') << setw(num_width) << right
-             << player.stats.ties << " " << vertical;
+             << player.stats.ties << " " << vertical << " "
+             << setfill(' ') << setw(usage_width) << right
+             << print_cpu_seconds(player.usage) << " " << vertical << " "
+             << setfill(' ') << setw(usage_width) << right
+             << print_max_memory(player.usage) << " " << vertical;
         info.display_row++; 
     }
     info.display_row++;
@@ -338,7 +338,10 @@ void display_match_stats(DisplayInfo &info, MatchLog &match) {
         TOTAL_NUM_KILLED        = "Total # Ships Killed",
         TOTAL_NUM_HITS          = "Total # Hits",
         TOTAL_NUM_MISSES        = "Total # Misses",
-        TOTAL_NUM_DUPLICATES    = "Total # Duplicates";
+        TOTAL_NUM_DUPLICATES    = "Total # Duplicates",
+        CPU_TIME                = "CPU Time (s)",
+        MAX_MEMORY              = "Max Memory (KB)",
+        CONTEXT_SWITCHES        = "Context Switches";
     
     int percent1, percent2, size1, size2, col_width = 20;
     percent1 = calculate_avg_percent_board_hit(match.player1.stats.total_num_board_shot,
@@ -425,6 +428,24 @@ void display_match_stats(DisplayInfo &info, MatchLog &match) {
          << setfill(' ') << setw(col_width) << left << TOTAL_NUM_DUPLICATES << " " << vertical << " "
          << setfill(' ') << setw(size1) << right << match.player1.stats.total_duplicates << " " << vertical << " "
          << setfill(' ') << setw(size2) << right << match.player2.stats.total_duplicates << " " << vertical;
+    info.display_row++;
+
+    cout << conio::gotoRowCol(info.display_row, 1) << " "
+         << setfill(' ') << setw(col_width) << left << CPU_TIME << " " << vertical << " "
+         << setfill(' ') << setw(size1) << right << print_cpu_seconds(match.player1.usage) << " " << vertical << " "
+         << setfill(' ') << setw(size2) << right << print_cpu_seconds(match.player2.usage) << " " << vertical;
+    info.display_row++;
+
+    cout << conio::gotoRowCol(info.display_row, 1) << " "
+         << setfill(' ') << setw(col_width) << left << MAX_MEMORY << " " << vertical << " "
+         << setfill(' ') << setw(size1) << right << print_max_memory(match.player1.usage) << " " << vertical << " "
+         << setfill(' ') << setw(size2) << right << print_max_memory(match.player2.usage) << " " << vertical;
+    info.display_row++;
+
+    cout << conio::gotoRowCol(info.display_row, 1) << " "
+         << setfill(' ') << setw(col_width) << left << CONTEXT_SWITCHES << " " << vertical << " "
+         << setfill(' ') << setw(size1) << right << print_context_switches(match.player1.usage) << " " << vertical << " "
+         << setfill(' ') << setw(size2) << right << print_context_switches(match.player2.usage) << " " << vertical;
     info.display_row += 2;
 
     return;
@@ -473,3 +494,20 @@ int calculate_avg_percent_board_hit(int total_num_board_shot, int board_size, in
     
     return clean;
 }
+
+string print_cpu_seconds(PlayerUsage &usage) {
+    if ( !usage.measured ) return "-";
+    ostringstream strm;
+    strm << fixed << setprecision(2) << usage.user_seconds + usage.system_seconds;
+    return strm.str();
+}
+
+string print_max_memory(PlayerUsage &usage) {
+    if ( !usage.measured ) return "-";
+    return to_string(usage.max_resident_kilobytes);
+}
+
+string print_context_switches(PlayerUsage &usage) {
+    if ( !usage.measured ) return "-";
+    return to_string(usage.voluntary_context_switches + usage.involuntary_context_switches);
+}
@@ -96,5 +96,20 @@ string clean_name(string name);
 /// @return Percentage returned out of 100.
 int calculate_avg_percent_board_hit(int total_num_board_shot, int board_size, int num_games);
 
+/// @brief Formats the user + system CPU time a player used, or a dash if it wasn't measured.
+/// @param usage What the player's process used.
+/// @return String value of the CPU time in seconds.
+string print_cpu_seconds(PlayerUsage &usage);
+
+/// @brief Formats the most memory a player had resident, or a dash if it wasn't measured.
+/// @param usage What the player's process used.
+/// @return String value of the memory in kilobytes.
+string print_max_memory(PlayerUsage &usage);
+
+/// @brief Formats the context switches a player made (voluntary + involuntary), or a dash if it wasn't measured.
+/// @param usage What the player's process used.
+/// @return String value of the context switches.
+string print_context_switches(PlayerUsage &usage);
+
 #endif
 
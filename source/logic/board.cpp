@@ -30,6 +30,8 @@ void clear_boards(Board &board) {
         for (int j = 0; j < size; j++) {
             board.board1[i][j] = WATER;
             board.board2[i][j] = WATER;
+            board.ship_index1[i][j] = -1;
+            board.ship_index2[i][j] = -1;
         }
     }
     return;
@@ -71,6 +73,30 @@ void store_ship_board_value(
     return;
 }
 
+void store_ship_board_index(Board &board, PlayerNum num, Ship &ship, int index) {
+    assert(board.size >= MIN_BOARD_SIZE);
+    assert(board.size <= MAX_BOARD_SIZE);
+    assert(num == PLAYER_1 || num == PLAYER_2);
+    assert(index >= 0);
+    assert(index < board.size * board.size);
+    assert(ship.dir == HORIZONTAL || ship.dir == VERTICAL);
+    assert(
+        (ship.dir == HORIZONTAL && (ship.col + (ship.len-1) < board.size)) ||
+        (ship.dir == VERTICAL && (ship.row + (ship.len-1) < board.size))
+    );
+
+    int r = ship.row, c = ship.col;
+    int rm = ship.dir == VERTICAL, cm = ship.dir == HORIZONTAL;
+    int rv, cv;
+    for (int l = 0; l < ship.len; l++) {
+        rv = r + (l * rm);
+        cv = c + (l * cm);
+        if (num == PLAYER_1) board.ship_index1[rv][cv] = (int8_t)index;
+        else board.ship_index2[rv][cv] = (int8_t)index;
+    }
+    return;
+}
+
 void store_shot_board_value(Board &board, PlayerNum num, Shot &shot) {
     assert(board.size >= MIN_BOARD_SIZE);
     assert(board.size <= MAX_BOARD_SIZE);
@@ -101,34 +127,14 @@ BoardValue get_shot_board_value(Board &board, PlayerNum num, Shot &shot) {
     else return (BoardValue)board.board2[shot.row][shot.col];
 }
 
-bool board_ship_died(Board &board, PlayerNum num, Ship &ship) {
+int get_ship_board_index(Board &board, PlayerNum num, Shot &shot) {
     assert(board.size >= MIN_BOARD_SIZE);
     assert(board.size <= MAX_BOARD_SIZE);
     assert(num == PLAYER_1 || num == PLAYER_2);
-    assert(ship.row >= 0);
-    assert(ship.row < board.size);
-    assert(ship.col >= 0);
-    assert(ship.col < board.size);
-    assert(ship.dir == HORIZONTAL || ship.dir == VERTICAL);
-    assert(
-        (ship.dir == HORIZONTAL && (ship.col + (ship.len-1) < board.size)) ||
-        (ship.dir == VERTICAL && (ship.row + (ship.len-1) < board.size))
-    );
-
-    int r = ship.row, c = ship.col;
-    int rm = ship.dir == VERTICAL, cm = ship.dir == HORIZONTAL;
-    int rv, cv;
-    BoardValue value;
-    for (int l = 0; l < ship.len; l++) {
-        rv = r + (l * rm);
-        cv = c + (l * cm);
-        if (num == PLAYER_1) value = (BoardValue)board.board1[rv][cv];
-        else value = (BoardValue)board.board2[rv][cv];
-
-        if (value != HIT && value != DUPLICATE_HIT) {
-            return false;
-        }
-    }
-    return true;
+    assert(shot.row >= 0);
+    assert(shot.row < board.size);
+    assert(shot.col >= 0);
+    assert(shot.col < board.size);
+    if (num == PLAYER_1) return board.ship_index1[shot.row][shot.col];
+    else return board.ship_index2[shot.row][shot.col];
 }
-
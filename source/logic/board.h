@@ -15,6 +15,9 @@
 struct Board {
     char board1[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
     char board2[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
+    // index of the ship on each square, -1 if there isn't one. Lets a hit go straight to the ship it hit.
+    int8_t ship_index1[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
+    int8_t ship_index2[MAX_BOARD_SIZE][MAX_BOARD_SIZE];
     int size;
 };
 
@@ -49,6 +52,13 @@ void store_ship_board_value(
     BoardValue value
 );
 
+/// @brief Stores which ship is on each square the ship takes up.
+/// @param board board struct to use.
+/// @param num number representing the player board to store to.
+/// @param ship Ship data structure to store.
+/// @param index Index of the ship in the player's ships.
+void store_ship_board_index(Board &board, PlayerNum num, Ship &ship, int index);
+
 /// @brief Stores a shot value into a board.
 /// @param board board struct to use.
 /// @param num number representing the player board to store to.
@@ -67,12 +77,12 @@ void store_shot_board_value(Board &board, PlayerNum num, Shot &shot);
 /// @return BoardValue value of board.
 BoardValue get_shot_board_value(Board &board, PlayerNum num, Shot &shot);
 
-/// @brief Calculates whether a ship is dead or not.
-/// @param board board struct to use.
+/// @brief Gets the index of the ship a shot landed on.
+/// @param board Board struct to use.
 /// @param num number to decide which board.
-/// @param ship Ship structure to check the value of.
-/// @return True if ship dead, false if not.
-bool board_ship_died(Board &board, PlayerNum num, Ship &ship);
+/// @param shot Shot data structure to check.
+/// @return Index of the ship in the player's ships, -1 if there isn't one.
+int get_ship_board_index(Board &board, PlayerNum num, Shot &shot);
 
 #endif
 
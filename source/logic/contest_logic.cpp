@@ -38,6 +38,8 @@ void initialize_players(
         player.played = true;
         player.error.type = OK;
         memset(&player.stats, 0, sizeof(ContestStats));
+        player.usage = PlayerUsage();
+        player.usage_matches = 0;
 
         wake_up_test(player, connect, socket_name);
         if ( player.error.type != OK ) {
@@ -123,6 +125,7 @@ void append_alive_players_to_round(
             alive_player.player_idx = i;
             alive_player.exec = players.at(i).exec;
             alive_player.error.type = OK;
+            alive_player.usage = PlayerUsage();
 
            round_players.push_back(alive_player); 
         }
@@ -258,6 +261,18 @@ void collect_contest_player_stats(
     c_player.stats.total_losses += m_player.stats.losses;
     c_player.stats.total_ties += m_player.stats.ties;
 
+    if ( m_player.usage.measured ) {
+        c_player.usage.user_seconds += m_player.usage.user_seconds;
+        c_player.usage.system_seconds += m_player.usage.system_seconds;
+        if ( m_player.usage.max_resident_kilobytes > c_player.usage.max_resident_kilobytes ) {
+            c_player.usage.max_resident_kilobytes = m_player.usage.max_resident_kilobytes;
+        }
+        c_player.usage.voluntary_context_switches += m_player.usage.voluntary_context_switches;
+        c_player.usage.involuntary_context_switches += m_player.usage.involuntary_context_switches;
+        c_player.usage.measured = true;
+        c_player.usage_matches++;
+    }
+
     c_player.error = m_player.error;
     if ( c_player.error.type != OK ) c_player.lives = MIN_LIVES;
     return;
@@ -313,6 +328,7 @@ void collect_match_player_stats(
 ) {
     c_player.error = m_player.error;
     c_player.stats = m_player.stats;
+    c_player.usage = m_player.usage;
     return;
 }
 
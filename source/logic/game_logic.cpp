@@ -106,9 +106,13 @@ int handle_ship_placement(GameLog &game, Connection &connect, Board &board, int
 
     store_ship_board_value(board, PLAYER_1, ship1, SHIP);
     store_ship_board_value(board, PLAYER_2, ship2, SHIP);
+    store_ship_board_index(board, PLAYER_1, ship1, (int)game.player1.ships.size());
+    store_ship_board_index(board, PLAYER_2, ship2, (int)game.player2.ships.size());
 
     ship1.alive = true;
     ship2.alive = true;
+    ship1.hits_left = ship1.len;
+    ship2.hits_left = ship2.len;
 
     game.player1.ships.push_back(ship1);
     game.player2.ships.push_back(ship2);
@@ -190,8 +194,8 @@ int handle_shots(
     calculate_shot_value(game.player1.stats, shot1, PLAYER_2, board);    
     calculate_shot_value(game.player2.stats, shot2, PLAYER_1, board);    
 
-    shot1.ship_sunk_idx = find_dead_ship(game.player2, PLAYER_2, board);
-    shot2.ship_sunk_idx = find_dead_ship(game.player1, PLAYER_1, board);
+    shot1.ship_sunk_idx = find_dead_ship(game.player2, PLAYER_2, board, shot1);
+    shot2.ship_sunk_idx = find_dead_ship(game.player1, PLAYER_1, board, shot2);
 
     if ( shot1.ship_sunk_idx != -1 ) game.player1.stats.ships_killed++;
     if ( shot2.ship_sunk_idx != -1 ) game.player2.stats.ships_killed++;
@@ -289,22 +293,19 @@ void calculate_shot_value(
     return;
 }
 
-int find_dead_ship(GamePlayer &player, PlayerNum num, Board &board) {
-    int dead_index = -1;
+int find_dead_ship(GamePlayer &player, PlayerNum num, Board &board, Shot &shot) {
+    // only a new hit can kill a ship, and it can only kill the ship it hit.
+    if (shot.value != HIT) return -1;
 
-    for (int s = 0; s < (int)player.ships.size(); s++) {
-        if ( !player.ships.at(s).alive ) continue;
-
-        Ship &ship = player.ships.at(s);
-        
-        if (board_ship_died(board, num, ship)) {
-            dead_index = s;
-            ship.alive = false;
-            store_ship_board_value(board, num, ship, KILL);
-            break;
-        }
-    }
-    return dead_index;
+    int index = get_ship_board_index(board, num, shot);
+    assert(index >= 0 && index < (int)player.ships.size());
+    Ship &ship = player.ships.at(index);
+    ship.hits_left--;
+    if (ship.hits_left > 0) return -1;
+
+    ship.alive = false;
+    store_ship_board_value(board, num, ship, KILL);
+    return index;
 }
 
 int count_alive_ships(GamePlayer &player) {
@@ -103,12 +103,13 @@ void calculate_shot_value(
     Board &board
 );
 
-/// @brief Finds a dead ship on a board.
+/// @brief Counts a hit against the ship it landed on, and finds out if that killed it.
 /// @param player Struct that stores player data.
 /// @param num PlayerNum to determine which player.
 /// @param board Board struct to check for a dead ship in.
+/// @param shot Shot that was just taken on this player's board, after its value was calculated.
 /// @return Index of a dead ship, -1 if none.
-int find_dead_ship(GamePlayer &player, PlayerNum num, Board &board);
+int find_dead_ship(GamePlayer &player, PlayerNum num, Board &board, Shot &shot);
 
 /// @brief Checks players ships and counts the number of alive ships.
 /// @param player Struct that stores player data.
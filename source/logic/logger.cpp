@@ -100,6 +100,10 @@ json convert_contest_player(ContestPlayer &player) {
     log[TOTAL_WINS_KEY] = player.stats.total_wins;
     log[TOTAL_LOSSES_KEY] = player.stats.total_losses;
     log[TOTAL_TIES_KEY] = player.stats.total_ties;
+    if ( player.usage.measured ) {
+        log[USAGE_KEY] = convert_usage(player.usage);
+    }
+    log[USAGE_MATCHES_KEY] = player.usage_matches;
     log[ERROR_KEY] = convert_error(player.error);
     return log;
 }
@@ -130,6 +134,15 @@ bool validate_contest_player_log(ContestPlayer &player, json &log) {
     player.stats.total_wins = (int)log[TOTAL_WINS_KEY];
     player.stats.total_losses = (int)log[TOTAL_LOSSES_KEY];
     player.stats.total_ties = (int)log[TOTAL_TIES_KEY];
+
+    if ( !validate_usage_log(player.usage, log) ) {
+        return false;
+    }
+    player.usage_matches = 0;
+    if ( check_contains(log, USAGE_MATCHES_KEY) ) {
+        if ( !check_integer(log, USAGE_MATCHES_KEY) ) return false;
+        player.usage_matches = (int)log[USAGE_MATCHES_KEY];
+    }
     
     if ( !validate_error_log(player.error, log[ERROR_KEY]) ) {
         return false;
@@ -209,6 +222,9 @@ json convert_contest_match_player(ContestMatchPlayer &player) {
     log[PLAYER_IDX_KEY] = player.player_idx;
     log[GAME_RESULT_KEY] = player.match_result;
     log[STATS_KEY] = convert_match_stats(player.stats);
+    if ( player.usage.measured ) {
+        log[USAGE_KEY] = convert_usage(player.usage);
+    }
     log[ERROR_KEY] = convert_error(player.error);
     return log;
 }
@@ -229,6 +245,10 @@ bool validate_contest_match_player_log(ContestMatchPlayer &player, json &log) {
         return false;
     }
 
+    if ( !validate_usage_log(player.usage, log) ) {
+        return false;
+    }
+
     if ( !validate_error_log(player.error, log[ERROR_KEY]) ) {
         return false;
     }
@@ -317,6 +337,9 @@ json convert_match_player(MatchPlayer &player) {
     log[AI_NAME_KEY] = player.ai_name.c_str();
     log[AUTHOR_NAMES_KEY] = player.author_name.c_str();
     log[STATS_KEY] = convert_match_stats(player.stats);
+    if ( player.usage.measured ) {
+        log[USAGE_KEY] = convert_usage(player.usage);
+    }
     log[ERROR_KEY] = convert_error(player.error);
 
     return log;
@@ -337,6 +360,10 @@ bool validate_match_player_log(MatchPlayer &player, json &log) {
         return false;
     }
 
+    if ( !validate_usage_log(player.usage, log) ) {
+        return false;
+    }
+
     if ( !validate_error_log(player.error, log[ERROR_KEY]) ) {
         return false;
     }
@@ -382,6 +409,44 @@ bool validate_match_stats_log(MatchStats &stats, json &log) {
     return true;
 }
 
+json convert_usage(PlayerUsage &usage) {
+    json log = json::object();
+    log[USER_SECONDS_KEY] = usage.user_seconds;
+    log[SYSTEM_SECONDS_KEY] = usage.system_seconds;
+    log[MAX_RESIDENT_KEY] = usage.max_resident_kilobytes;
+    log[VOLUNTARY_CS_KEY] = usage.voluntary_context_switches;
+    log[INVOLUNTARY_CS_KEY] = usage.involuntary_context_switches;
+    return log;
+}
+
+bool validate_usage_log(PlayerUsage &usage, json &log) {
+    usage = PlayerUsage();
+    // a player that wasn't measured (like one that failed to start, or from an older log) has no usage.
+    if ( !check_contains(log, USAGE_KEY) ) {
+        return true;
+    }
+    if ( !check_object(log, USAGE_KEY) ) {
+        return false;
+    }
+    json &use = log[USAGE_KEY];
+    bool valid =
+        check_float(use, USER_SECONDS_KEY) &&
+        check_float(use, SYSTEM_SECONDS_KEY) &&
+        check_integer(use, MAX_RESIDENT_KEY) &&
+        check_integer(use, VOLUNTARY_CS_KEY) &&
+        check_integer(use, INVOLUNTARY_CS_KEY);
+    if ( !valid ) {
+        return false;
+    }
+    usage.user_seconds = (double)use[USER_SECONDS_KEY];
+    usage.system_seconds = (double)use[SYSTEM_SECONDS_KEY];
+    usage.max_resident_kilobytes = (long)use[MAX_RESIDENT_KEY];
+    usage.voluntary_context_switches = (long)use[VOLUNTARY_CS_KEY];
+    usage.involuntary_context_switches = (long)use[INVOLUNTARY_CS_KEY];
+    usage.measured = true;
+    return true;
+}
+
 json convert_error(Error &error) {
     json log = json::object();
     log[ERROR_TYPE_KEY] = error.type;
@@ -134,6 +134,17 @@ json convert_match_stats(MatchStats &stats);
 /// @return true if valid MatchStats, false if not.
 bool validate_match_stats_log(MatchStats &stats, json &log);
 
+/// @brief Converts PlayerUsage struct into JSON.
+/// @param usage PlayerUsage struct to convert from.
+/// @return JSON object from a PlayerUsage struct.
+json convert_usage(PlayerUsage &usage);
+
+/// @brief Validates the PlayerUsage struct in a JSON object, which is left out when it wasn't measured.
+/// @param usage PlayerUsage struct to store validated data into.
+/// @param log JSON object to validate from, that may contain the usage.
+/// @return true if valid (or missing) PlayerUsage, false if not.
+bool validate_usage_log(PlayerUsage &usage, json &log);
+
 /// @brief Converts Error struct into JSON.
 /// @param error Error struct to convert from.
 /// @return JSON object from a Error struct.
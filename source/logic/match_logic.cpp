@@ -15,6 +15,8 @@ MatchLog run_match(Connection &connect, MatchOptions &options, const char *socke
     match.player2.error.type = OK;
     memset(&match.player1.stats, 0, sizeof(MatchStats));
     memset(&match.player2.stats, 0, sizeof(MatchStats));
+    match.player1.usage = PlayerUsage();
+    match.player2.usage = PlayerUsage();
     match.player1.ai_name = options.exec1.file_name;
     match.player2.ai_name = options.exec2.file_name;
     int status = 0;
@@ -29,6 +31,8 @@ MatchLog run_match(Connection &connect, MatchOptions &options, const char *socke
     status = handle_start_match(match, connect, options);
     if (status) {
         handle_match_over(connect, status);
+        match.player1.usage = connect.player1.usage;
+        match.player2.usage = connect.player2.usage;
         return match;
     }
 
@@ -47,6 +51,8 @@ MatchLog run_match(Connection &connect, MatchOptions &options, const char *socke
     }
 
     handle_match_over(connect, status);
+    match.player1.usage = connect.player1.usage;
+    match.player2.usage = connect.player2.usage;
     gettimeofday(&end, NULL);
     store_elapsed_time(match, start, end);
 
@@ -181,19 +187,19 @@ void handle_match_over(Connection &connect, int last_status) {
     switch (last_status) {
     case -3:
         // kill both players. Both are tweaking.
-        kill_player(connect.player1.pid);
-        kill_player(connect.player2.pid);
+        kill_player(connect.player1);
+        kill_player(connect.player2);
         break;
     case -2:
         // Send message to player 1 to let it peacefully exit.
         send_msg(connect.player1.desc, connect.player1.msg);
         wait_player(connect.player1);
         // kill the troublemaker.
-        kill_player(connect.player2.pid);
+        kill_player(connect.player2);
         break;
     case -1:
         // kill the troublemaker.
-        kill_player(connect.player1.pid);
+        kill_player(connect.player1);
         // Send message to player 2 to let it peacefully exit.
         send_msg(connect.player2.desc, connect.player2.msg);
         wait_player(connect.player2);
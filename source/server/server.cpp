@@ -113,6 +113,7 @@ ErrorType start_player(ConnectionPlayer &connect, int server_desc, const char *p
     ErrorType err;
 
     char *argv[] = { (char *)path, (char *)socket_name, NULL};
+    connect.usage = PlayerUsage();
     err = run_player(path, argv, connect.pid);
     if ( err != OK ) {
         if ( connect.pid != -1) kill_player(connect.pid);
@@ -126,58 +127,79 @@ ErrorType start_player(ConnectionPlayer &connect, int server_desc, const char *p
 }
 
 ErrorType run_player(const char *path, char **argv, pid_t &pid) {
-    pid = fork();   // create a child process
-
-    switch (pid) {
-        case 0: // child process
-            // set CTRL-C to kill the children.
-            signal(SIGINT, SIG_DFL);
-            if ( execv(path, argv) == -1 ) {
-                print_error(strerror(errno), __FILE__, __LINE__);
-                exit(-1); // just exit this process asap
-            }
-            break;
-        case -1:    // error, exit out of this process.
-            print_error(strerror(errno), __FILE__, __LINE__);
-            exit(-1);
-        default:
-            break;
+    // posix_spawn doesn't copy the controller's memory like fork does, which adds up over a whole contest.
+    posix_spawnattr_t attr;
+    sigset_t default_signals;
+    int err = posix_spawnattr_init(&attr);
+    if ( err == 0 ) {
+        // set CTRL-C to kill the children.
+        sigemptyset(&default_signals);
+        sigaddset(&default_signals, SIGINT);
+        err = posix_spawnattr_setsigdefault(&attr, &default_signals);
+        if ( err == 0 ) err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+        if ( err == 0 ) err = posix_spawn(&pid, path, NULL, &attr, argv, environ);
+        posix_spawnattr_destroy(&attr);
+    }
+    if ( err != 0 ) {
+        print_error(strerror(err), __FILE__, __LINE__);
+        pid = -1;
+        return ErrFork;
     }
     return OK;
 }
 
 void wait_player(ConnectionPlayer &connect) {
-    // status can't initially be null.
-    int status = 1;
+    int status = 0;
+    if ( !wait_player_exit(connect.pid, status, connect.usage) ) {
+        kill_player(connect);
+        return;
+    }
+    if ( WIFEXITED(status) && WEXITSTATUS(status) != 0 ) {
+        fprintf(stderr, "Player exit status: %d\n", WEXITSTATUS(status));
+    }
+    return;
+}
 
-    timeval start, end, difference;
-    gettimeofday(&start, NULL);
-    end.tv_sec = start.tv_sec + SECONDS;
-    end.tv_usec = start.tv_usec + MICROSECONDS;
-    
-    bool exited = false;
-
-    do {
-        // wait for player for the default time length
-        waitpid(connect.pid, &status, WNOHANG);
-        if ( WIFEXITED(status) ) {
-            int exit_status = WEXITSTATUS(status);
-            if ( exit_status != 0 ) {
-                fprintf(stderr, "Player exit status: %d\n", exit_status);
-            }
-            exited = true;
-            break;
+bool wait_player_exit(pid_t pid, int &status, PlayerUsage &usage) {
+    int timeout_ms = (int)(SECONDS * 1000 + MICROSECONDS / 1000);
+    rusage ru = {};
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // a pidfd is readable as soon as the player exits, so nothing runs while we wait.
+    int pid_desc = (int)syscall(SYS_pidfd_open, pid, 0);
+    if ( pid_desc != -1 ) {
+        pollfd pfd = {};
+        pfd.fd = pid_desc;
+        pfd.events = POLLIN;
+        int rc;
+        do {
+            rc = poll(&pfd, 1, timeout_ms);
+        } while ( rc == -1 && errno == EINTR );
+        close(pid_desc);
+        if ( rc == 1 ) {
+            if ( wait4(pid, &status, 0, &ru) != pid ) return false;
+            store_player_usage(usage, ru);
+            return true;
+        } else if ( rc == 0 ) {
+            return false;
         }
-        gettimeofday(&start, NULL);
-        difference.tv_sec = end.tv_sec - start.tv_sec;
-        difference.tv_usec = end.tv_usec - start.tv_usec;
-    } while (difference.tv_sec > 0 || (difference.tv_sec == 0 && difference.tv_usec >= 0));
-
-    if ( !exited ) {
-        kill_player(connect.pid);
     }
-
-    return;
+#endif
+
+    // no pidfds (older kernels, or not Linux), check in on the player every few milliseconds instead.
+    timespec sleep_time = {};
+    sleep_time.tv_nsec = 5 * 1000 * 1000;
+    for ( int waited_ms = 0; waited_ms < timeout_ms; waited_ms += 5 ) {
+        pid_t result = wait4(pid, &status, WNOHANG, &ru);
+        if ( result == pid ) {
+            store_player_usage(usage, ru);
+            return true;
+        } else if ( result == -1 ) {
+            return false;
+        }
+        nanosleep(&sleep_time, NULL);
+    }
+    return false;
 }
 
 void kill_player(pid_t &pid) {
@@ -187,6 +209,30 @@ void kill_player(pid_t &pid) {
     return;
 }
 
+void kill_player(ConnectionPlayer &connect) {
+    int status = 1;
+    rusage ru = {};
+    kill(connect.pid, SIGKILL);
+    if ( wait4(connect.pid, &status, 0, &ru) == connect.pid ) {
+        store_player_usage(connect.usage, ru);
+    }
+    return;
+}
+
+void store_player_usage(PlayerUsage &usage, rusage &ru) {
+    usage.user_seconds = (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6;
+    usage.system_seconds = (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    usage.max_resident_kilobytes = ru.ru_maxrss / 1024; // bytes on macOS, kilobytes on Linux.
+#else
+    usage.max_resident_kilobytes = ru.ru_maxrss;
+#endif
+    usage.voluntary_context_switches = ru.ru_nvcsw;
+    usage.involuntary_context_switches = ru.ru_nivcsw;
+    usage.measured = true;
+    return;
+}
+
 
 /* ────────────────────────────── *
  * MESSAGE TRANSMISSION FUNCTIONS *
@@ -14,8 +14,14 @@
 
 #include <cerrno>
 #include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <sys/signal.h>
 #include <sys/socket.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -32,6 +38,7 @@ const long MICROSECONDS = 500000; // 0.5 seconds
 struct ConnectionPlayer {
     int desc;
     pid_t pid;
+    PlayerUsage usage;  // NOTE: filled in once the player is waited on (or killed) at match over.
     char msg[MAX_MSG_SIZE];
 };
 
@@ -89,10 +96,26 @@ ErrorType run_player(const char *path, char **argv, pid_t &pid);
 /// @param connect Connection Player data.
 void wait_player(ConnectionPlayer &connect);
 
+/// @brief Waits for a player process to exit, for up to SECONDS + MICROSECONDS.
+/// @param pid player pid to wait for.
+/// @param status set to the player's wait status once it exited.
+/// @param usage set to what the player's process used once it exited.
+/// @return true if the player exited (and was collected), false if it's still running.
+bool wait_player_exit(pid_t pid, int &status, PlayerUsage &usage);
+
 /// @brief Kills a player process. Do this when the match is over, or there is an error.
 /// @param pid player pid to kill.
 void kill_player(pid_t &pid);
 
+/// @brief Kills a player process, and collects what it used. Do this when the match is over.
+/// @param connect Connection Player data.
+void kill_player(ConnectionPlayer &connect);
+
+/// @brief Converts what wait4() collected into the usage stored in the logs.
+/// @param usage PlayerUsage struct to store into.
+/// @param ru rusage struct from wait4().
+void store_player_usage(PlayerUsage &usage, rusage &ru);
+
 
 /* ────────────────────────────── *
  * MESSAGE TRANSMISSION FUNCTIONS *